@@ -0,0 +1,270 @@
+#include "BulkSender.hpp"
+#include "UdpBulk.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+
+static constexpr std::int64_t INITIAL_RTO_NANOS = 200 * 1000 * 1000;
+
+struct BulkSender::Transfer {
+    UdpBulk::Chunk header;
+    std::vector<std::uint8_t> wire;        // BE payload of all chunks
+    std::vector<std::uint8_t> datagram;
+    std::vector<State> state;
+    std::vector<std::int64_t> sentAt;
+    std::deque<std::uint32_t> lost;        // to retransmit, in order
+    std::uint32_t nextNew = 0;
+    std::uint32_t cumulative = 0;          // every chunk < this is acked
+    std::uint32_t inFlight = 0;
+    double cwnd = 0.0;
+    double ssthresh = 0.0;
+    std::uint32_t recoveryPoint = 0;       // no further cut until cumulative passes it
+    std::int64_t nextPacedNanos = 0;
+    bool done = false;
+    Result result;
+};
+
+BulkSender::BulkSender(UdpDoubleSender& sender)
+    : BulkSender(sender, Config())
+{
+}
+
+BulkSender::BulkSender(UdpDoubleSender& sender, const Config& cfg)
+    : sender_(sender),
+      cfg_(cfg),
+      nextId_((std::uint32_t)nowNanos() * 0x9E3779B9u),
+      rto_(INITIAL_RTO_NANOS)
+{
+    if (cfg_.initialWindow < 1 || cfg_.maxWindow < cfg_.initialWindow || cfg_.dupThreshold < 1)
+        throw std::invalid_argument("BulkSender: bad window configuration");
+}
+
+void BulkSender::updateRtt(std::int64_t sample) {
+    if (sample <= 0) return;
+    if (srtt_ == 0) {
+        srtt_ = sample;
+        rttvar_ = sample / 2;
+    } else {
+        const std::int64_t err = sample - srtt_;
+        rttvar_ += ((err < 0 ? -err : err) - rttvar_) / 4;
+        srtt_ += err / 8;
+    }
+    rto_ = std::min(cfg_.maxRtoNanos, std::max(cfg_.minRtoNanos, srtt_ + 4 * rttvar_));
+}
+
+void BulkSender::transmit(Transfer& t, std::uint32_t idx, std::int64_t now) {
+    UdpBulk::Chunk c = t.header;
+    const std::size_t first = std::size_t(idx) * c.chunkDoubles;
+    c.index = idx;
+    c.count = (std::uint16_t)std::min<std::size_t>(c.chunkDoubles, c.totalDoubles - first);
+    c.sentNanos = (std::uint64_t)now;
+    UdpBulk::encodeChunkHeader(t.datagram.data(), c);
+    std::memcpy(t.datagram.data() + UdpBulk::CHUNK_HEADER_BYTES, t.wire.data() + first * 8, std::size_t(c.count) * 8);
+
+    const bool retransmit = t.state[idx] != State::Unsent;
+    try {
+        sender_.sendDatagram(t.datagram.data(), UdpBulk::CHUNK_HEADER_BYTES + std::size_t(c.count) * 8);
+    } catch (const std::exception&) {
+        // e.g. ENOBUFS: treat as sent and lost; the timer recovers it
+    }
+    t.state[idx] = State::InFlight;
+    t.sentAt[idx] = now;
+    ++t.inFlight;
+    ++t.result.transmissions;
+    if (retransmit) ++t.result.retransmits;
+
+    if (cfg_.maxBytesPerSecond > 0.0) {
+        const double bytes = (double)(UdpBulk::CHUNK_HEADER_BYTES + std::size_t(c.count) * 8);
+        t.nextPacedNanos = std::max(t.nextPacedNanos, now) + (std::int64_t)(bytes / cfg_.maxBytesPerSecond * 1e9);
+    }
+}
+
+void BulkSender::markAcked(Transfer& t, std::uint32_t idx) {
+    if (t.state[idx] == State::Acked) return;
+    if (t.state[idx] == State::InFlight) --t.inFlight;
+    t.state[idx] = State::Acked;
+
+    // grow the window outside recovery: slow start, then ~1 chunk per RTT
+    if (t.cumulative >= t.recoveryPoint) {
+        t.cwnd += (t.cwnd < t.ssthresh) ? 1.0 : 1.0 / t.cwnd;
+        t.cwnd = std::min(t.cwnd, (double)cfg_.maxWindow);
+    }
+}
+
+void BulkSender::onLoss(Transfer& t) {
+    if (t.cumulative < t.recoveryPoint) return;   // one cut per window of data
+    t.ssthresh = std::max(2.0, t.cwnd / 2.0);
+    t.cwnd = t.ssthresh;
+    t.recoveryPoint = t.nextNew;
+}
+
+void BulkSender::onAck(Transfer& t, const std::uint8_t* msg, std::size_t n, std::int64_t now) {
+    UdpBulk::Ack a;
+    if (!UdpBulk::decodeAck(msg, n, a) || a.transferId != t.header.transferId) return;
+
+    updateRtt(now - (std::int64_t)a.echoNanos);
+
+    if (a.flags & UdpBulk::FLAG_CRC_FAILED) {
+        t.result.crcFailed = true;
+        t.done = true;
+        return;
+    }
+
+    const std::uint32_t total = t.header.totalChunks;
+    const std::uint32_t cum = std::min(a.cumulative, total);
+    for (std::uint32_t i = t.cumulative; i < cum; ++i) markAcked(t, i);
+    t.cumulative = std::max(t.cumulative, cum);
+
+    std::uint32_t highest = 0;
+    bool anySack = false;
+    for (std::size_t w = 0; w < a.sackWords; ++w) {
+        std::uint64_t bits = a.sack[w];
+        while (bits) {
+#if defined(_MSC_VER)
+            unsigned long b;
+            _BitScanForward64(&b, bits);
+#else
+            const unsigned b = (unsigned)__builtin_ctzll(bits);
+#endif
+            const std::uint64_t idx = std::uint64_t(cum) + 1 + w * 64 + b;
+            if (idx < total) {
+                markAcked(t, (std::uint32_t)idx);
+                highest = (std::uint32_t)idx;
+                anySack = true;
+            }
+            bits &= bits - 1;
+        }
+    }
+
+    if (a.flags & UdpBulk::FLAG_COMPLETE) {
+        t.done = true;
+        t.result.ok = true;
+        return;
+    }
+
+    // RACK-like loss detection: an in-flight chunk sent before the chunk
+    // this ACK echoes, with dupThreshold acked chunks above it, is lost.
+    if (anySack) {
+        int ackedAbove = 0;
+        bool lossFound = false;
+        for (std::uint32_t i = highest + 1; i-- > cum;) {
+            if (t.state[i] == State::Acked) {
+                ++ackedAbove;
+            } else if (t.state[i] == State::InFlight && ackedAbove >= cfg_.dupThreshold &&
+                       t.sentAt[i] < (std::int64_t)a.echoNanos) {
+                t.state[i] = State::Lost;
+                --t.inFlight;
+                t.lost.push_front(i);   // walking down: front keeps index order
+                ++t.result.fastRetransmits;
+                lossFound = true;
+            }
+        }
+        if (lossFound) onLoss(t);
+    }
+}
+
+void BulkSender::checkTimeouts(Transfer& t, std::int64_t now) {
+    bool expired = false;
+    for (std::uint32_t i = t.cumulative; i < t.nextNew; ++i) {
+        if (t.state[i] == State::InFlight && now - t.sentAt[i] >= rto_) {
+            t.state[i] = State::Lost;
+            --t.inFlight;
+            t.lost.push_back(i);
+            expired = true;
+        }
+    }
+    if (!expired) return;
+
+    // timeout: the path may be gone; restart from a small window, back off
+    ++t.result.timeouts;
+    t.ssthresh = std::max(2.0, t.cwnd / 2.0);
+    t.cwnd = 2.0;
+    t.recoveryPoint = t.nextNew;
+    rto_ = std::min(cfg_.maxRtoNanos, rto_ * 2);
+    std::sort(t.lost.begin(), t.lost.end());
+    t.lost.erase(std::unique(t.lost.begin(), t.lost.end()), t.lost.end());
+}
+
+BulkSender::Result BulkSender::send(const double* data, std::size_t count) {
+    if (!data || count == 0) throw std::invalid_argument("BulkSender: no data");
+
+    const int payload = sender_.getEffectiveMaxPayload();
+    const std::uint32_t chunkDoubles = (std::uint32_t)std::min<int>(0xFFFF, (payload - (int)UdpBulk::CHUNK_HEADER_BYTES) / 8);
+    if (payload <= (int)UdpBulk::CHUNK_HEADER_BYTES + 8) throw std::runtime_error("BulkSender: payload too small");
+    if (count > 0xFFFFFFFFull) throw std::invalid_argument("BulkSender: transfer too large");
+
+    Transfer t;
+    t.wire.resize(count * 8);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &data[i], 8);
+        for (int b = 0; b < 8; ++b) t.wire[i * 8 + b] = std::uint8_t(bits >> (56 - 8 * b));
+    }
+    t.header.transferId = nextId_++;
+    t.header.totalDoubles = (std::uint32_t)count;
+    t.header.chunkDoubles = chunkDoubles;
+    t.header.totalChunks = (std::uint32_t)((count + chunkDoubles - 1) / chunkDoubles);
+    t.header.crc = UdpBulk::crc32(t.wire.data(), t.wire.size());
+    t.datagram.resize(UdpBulk::CHUNK_HEADER_BYTES + std::size_t(chunkDoubles) * 8);
+    t.state.assign(t.header.totalChunks, State::Unsent);
+    t.sentAt.assign(t.header.totalChunks, 0);
+    t.cwnd = cfg_.initialWindow;
+    t.ssthresh = cfg_.maxWindow;
+    t.result.transferId = t.header.transferId;
+    t.result.chunks = t.header.totalChunks;
+    t.result.bytes = count * 8;
+
+    std::uint8_t msg[512];
+    const std::int64_t start = nowNanos();
+    const std::int64_t deadline = start + cfg_.timeoutNanos;
+
+    while (!t.done) {
+        std::int64_t now = nowNanos();
+        if (now >= deadline) break;
+
+        // fill the window: losses first, then new chunks
+        while (t.inFlight < (std::uint32_t)t.cwnd && now >= t.nextPacedNanos) {
+            std::uint32_t idx;
+            if (!t.lost.empty()) {
+                idx = t.lost.front();
+                t.lost.pop_front();
+                if (t.state[idx] != State::Lost) continue;
+            } else if (t.nextNew < t.header.totalChunks) {
+                idx = t.nextNew++;
+            } else {
+                break;
+            }
+            transmit(t, idx, now);
+            // drain ACKs between sends so the window tracks the receiver
+            while (std::size_t n = sender_.receiveDatagram(UdpDoubleSender::Reply::BulkAck, msg, sizeof(msg), 0)) onAck(t, msg, n, nowNanos());
+            if (t.done) break;
+            now = nowNanos();
+        }
+        if (t.done) break;
+
+        // wait for an ACK, the next pacing slot or the earliest timer
+        // (retransmits make sentAt non-monotonic in index, so scan them all)
+        std::int64_t wake = deadline;
+        for (std::uint32_t i = t.cumulative; i < t.nextNew; ++i)
+            if (t.state[i] == State::InFlight) wake = std::min(wake, t.sentAt[i] + rto_);
+        if (t.inFlight < (std::uint32_t)t.cwnd && (!t.lost.empty() || t.nextNew < t.header.totalChunks))
+            wake = std::min(wake, t.nextPacedNanos);
+        const int waitMs = (int)std::max<std::int64_t>(0, (wake - nowNanos() + 999999) / 1000000);
+
+        if (std::size_t n = sender_.receiveDatagram(UdpDoubleSender::Reply::BulkAck, msg, sizeof(msg), waitMs)) {
+            onAck(t, msg, n, nowNanos());
+            while (!t.done && (n = sender_.receiveDatagram(UdpDoubleSender::Reply::BulkAck, msg, sizeof(msg), 0))) onAck(t, msg, n, nowNanos());
+        }
+        if (!t.done) checkTimeouts(t, nowNanos());
+    }
+
+    Result& r = t.result;
+    r.seconds = (double)(nowNanos() - start) * 1e-9;
+    r.megabytesPerSecond = (r.ok && r.seconds > 0.0) ? (double)r.bytes / r.seconds / 1e6 : 0.0;
+    r.retransmitRatio = r.chunks ? (double)r.retransmits / (double)r.chunks : 0.0;
+    r.srttNanos = srtt_;
+    return r;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "UdpDoubleSender.hpp"
+#include "SteadyClock.hpp"
+
+// Reliable bulk upload (trajectories, parameter sets) over a sender's
+// socket; the receiver side is UdpDoubleReceiver::enableBulk/takeBulk.
+//
+// The data is cut into chunks that fill the sender's payload limit (see
+// UdpBulk.hpp). A sliding window of chunks is kept in flight:
+// - selective ACKs; a chunk is declared lost once dupThreshold chunks
+//   sent after it are acknowledged, and retransmitted at once
+// - a retransmit timer from smoothed RTT (RFC 6298), with backoff
+// - TCP-like congestion window: slow start, then additive increase, and
+//   halved once per loss episode, so a concurrent real-time stream keeps
+//   its share; maxBytesPerSecond adds a hard pacing cap
+// - CRC-32 over the whole payload, checked by the receiver on completion
+//
+// send() blocks until the receiver confirms or the timeout expires. It
+// takes only BulkAck replies from the sender's socket (see
+// UdpDoubleSender::Reply), so pollReport(), negotiate() and syncClock()
+// may run on other threads meanwhile. One send() per sender at a time.
+class BulkSender {
+public:
+    struct Config {
+        int initialWindow = 16;                    // chunks
+        int maxWindow = 1024;
+        int dupThreshold = 3;
+        double maxBytesPerSecond = 0.0;            // <= 0: window-limited only
+        std::int64_t minRtoNanos = 2000000;
+        std::int64_t maxRtoNanos = 1000000000;
+        std::int64_t timeoutNanos = 30000000000LL; // whole transfer
+    };
+
+    struct Result {
+        bool ok = false;
+        bool crcFailed = false;
+        std::uint32_t transferId = 0;
+        std::uint32_t chunks = 0;
+        std::size_t bytes = 0;                     // payload bytes
+        std::uint64_t transmissions = 0;           // chunk datagrams sent
+        std::uint64_t retransmits = 0;
+        double retransmitRatio = 0.0;              // retransmits / chunks
+        std::uint64_t timeouts = 0;                // RTO expiries
+        std::uint64_t fastRetransmits = 0;         // SACK-detected losses
+        double seconds = 0.0;
+        double megabytesPerSecond = 0.0;
+        std::int64_t srttNanos = 0;
+    };
+
+    explicit BulkSender(UdpDoubleSender& sender);
+    BulkSender(UdpDoubleSender& sender, const Config& cfg);
+
+    Result send(const double* data, std::size_t count);
+
+    static std::int64_t nowNanos() { return SteadyClock::nowNanos(); }
+
+private:
+    enum class State : std::uint8_t { Unsent, InFlight, Lost, Acked };
+
+    struct Transfer;
+    void transmit(Transfer& t, std::uint32_t idx, std::int64_t now);
+    void onAck(Transfer& t, const std::uint8_t* msg, std::size_t n, std::int64_t now);
+    void markAcked(Transfer& t, std::uint32_t idx);
+    void onLoss(Transfer& t);
+    void checkTimeouts(Transfer& t, std::int64_t now);
+    void updateRtt(std::int64_t sample);
+
+private:
+    UdpDoubleSender& sender_;
+    const Config cfg_;
+    std::uint32_t nextId_;
+
+    // RTT estimate, kept across transfers
+    std::int64_t srtt_ = 0;
+    std::int64_t rttvar_ = 0;
+    std::int64_t rto_ = 0;
+};
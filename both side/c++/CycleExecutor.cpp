@@ -0,0 +1,216 @@
+#include "CycleExecutor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#if defined(_WIN32)
+  #include <windows.h>
+  #include <mmsystem.h>   // timeBeginPeriod (winmm)
+#else
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+CycleExecutor::CycleExecutor(Step step)
+    : CycleExecutor(std::move(step), Config())
+{
+}
+
+CycleExecutor::CycleExecutor(Step step, const Config& cfg)
+    : step_(std::move(step)),
+      cfg_(cfg),
+      deadline_((cfg.deadlineNanos > 0) ? cfg.deadlineNanos : cfg.periodNanos)
+{
+    if (!step_) throw std::invalid_argument("CycleExecutor needs a step function");
+    if (cfg.periodNanos <= 0) throw std::invalid_argument("CycleExecutor needs period > 0");
+}
+
+CycleExecutor::~CycleExecutor() {
+    stop();
+}
+
+int CycleExecutor::addInput(UdpDoubleReceiver& receiver, int source) {
+    if (running_) throw std::logic_error("addInput after start");
+    sources_.push_back(Source{&receiver, source});
+    cycle_.inputs.resize(sources_.size());
+    return (int)sources_.size() - 1;
+}
+
+int CycleExecutor::addOutput(UdpDoubleSender& sender, bool sparse) {
+    if (running_) throw std::logic_error("addOutput after start");
+    sinks_.push_back(Sink{&sender, sparse});
+    cycle_.outputs.resize(sinks_.size());
+    return (int)sinks_.size() - 1;
+}
+
+bool CycleExecutor::start() {
+    if (running_) return true;
+    running_ = true;
+    thread_ = std::thread(&CycleExecutor::loop, this, 0);
+    return true;
+}
+
+void CycleExecutor::stop() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+}
+
+void CycleExecutor::run(std::uint64_t maxCycles) {
+    running_ = true;
+    loop(maxCycles);
+    running_ = false;
+}
+
+// ---------- cycle loop ----------
+void CycleExecutor::loop(std::uint64_t maxCycles) {
+    if (cfg_.realtimePriority) setPriority(true);
+
+    const std::int64_t period = cfg_.periodNanos;
+    std::int64_t next = nowNanos();
+    std::uint64_t index = 0;
+    std::uint64_t done = 0;
+    std::uint64_t missed = 0;
+    int lateRun = 0;                       // consecutive cycles started late
+
+    while (running_ && (maxCycles == 0 || done < maxCycles)) {
+        waitUntil(next);
+        cycle_.index = index;
+        cycle_.missed = missed;
+        cycle_.catchingUp = lateRun > 0;
+        runCycle(next, nowNanos());
+        ++done;
+
+        next += period;
+        ++index;
+        missed = 0;
+        const std::int64_t now = nowNanos();
+        if (next > now) {
+            lateRun = 0;
+            continue;
+        }
+
+        // the next grid point already passed
+        if (cfg_.policy == OverrunPolicy::CatchUp && lateRun < cfg_.maxCatchUp) {
+            ++lateRun;
+            continue;
+        }
+        const std::int64_t behind = (now - next) / period + 1;
+        next += behind * period;
+        index += (std::uint64_t)behind;
+        missed = (std::uint64_t)behind;
+        lateRun = 0;
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.skipped += missed;
+    }
+
+    if (cfg_.realtimePriority) setPriority(false);
+}
+
+void CycleExecutor::runCycle(std::int64_t scheduled, std::int64_t wake) {
+    Cycle& c = cycle_;
+    c.scheduledNanos = scheduled;
+    c.startNanos = wake;
+    c.deadlineNanos = scheduled + deadline_;
+    c.degraded = degradedMode_;
+
+    // ---- receive ----
+    std::uint64_t stale = 0;
+    for (std::size_t k = 0; k < sources_.size(); ++k) {
+        Input& in = c.inputs[k];
+        const std::int64_t prevArrival = in.packet.arrivalNanos;
+        if (sources_[k].receiver->getLatest(sources_[k].source, in.packet)) {
+            in.fresh = !in.valid || in.packet.arrivalNanos != prevArrival;
+            in.valid = true;
+        } else {
+            in.fresh = false;
+        }
+        in.ageNanos = in.valid ? wake - in.packet.arrivalNanos : 0;
+        if (!in.fresh) ++stale;
+    }
+    const std::int64_t received = nowNanos();
+
+    // ---- compute ----
+    for (std::vector<double>& out : c.outputs) out.clear();   // keeps capacity
+    step_(c);
+    const std::int64_t computed = nowNanos();
+
+    // ---- send: back to back so the outputs leave together ----
+    std::uint64_t errors = 0;
+    for (std::size_t k = 0; k < sinks_.size(); ++k) {
+        const std::vector<double>& out = c.outputs[k];
+        if (out.empty()) continue;
+        try {
+            if (sinks_[k].sparse) sinks_[k].sender->sendSparseAutoSeq(out.data(), (int)out.size());
+            else sinks_[k].sender->sendAutoSeq(out.data(), (int)out.size());
+        } catch (const std::exception&) {
+            ++errors;
+        }
+    }
+    const std::int64_t sent = nowNanos();
+
+    // ---- overrun policy ----
+    const bool overrun = sent > c.deadlineNanos;
+    if (overrun) {
+        cleanRun_ = 0;
+        if (++overrunRun_ >= cfg_.degradeAfter && cfg_.policy == OverrunPolicy::Degrade) degradedMode_ = true;
+    } else {
+        overrunRun_ = 0;
+        if (++cleanRun_ >= cfg_.recoverAfter) degradedMode_ = false;
+    }
+
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    ++stats_.cycles;
+    if (overrun) ++stats_.overruns;
+    if (c.catchingUp) ++stats_.caughtUp;
+    if (c.degraded) ++stats_.degraded;
+    stats_.staleInputs += stale;
+    stats_.sendErrors += errors;
+    wake_.add(wake - scheduled);
+    receive_.add(received - wake);
+    compute_.add(computed - received);
+    send_.add(sent - computed);
+    total_.add(sent - wake);
+}
+
+// Sleeps to just before t, then spins the rest: sleep_until alone wakes
+// up to a scheduler tick late.
+void CycleExecutor::waitUntil(std::int64_t t) const {
+    const std::int64_t sleepTo = t - cfg_.spinNanos;
+    const std::int64_t now = nowNanos();
+    if (sleepTo > now) std::this_thread::sleep_for(std::chrono::nanoseconds(sleepTo - now));
+    while (nowNanos() < t) {
+    }
+}
+
+void CycleExecutor::setPriority(bool realtime) {
+#if defined(_WIN32)
+    // 1 ms scheduler tick for the sleeps while the loop runs
+    if (realtime) timeBeginPeriod(1);
+    else timeEndPeriod(1);
+    SetThreadPriority(GetCurrentThread(), realtime ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_NORMAL);
+#else
+    // needs CAP_SYS_NICE / rtprio; stays SCHED_OTHER otherwise
+    sched_param sp{};
+    sp.sched_priority = realtime ? std::max(1, sched_get_priority_max(SCHED_FIFO) - 10) : 0;
+    pthread_setschedparam(pthread_self(), realtime ? SCHED_FIFO : SCHED_OTHER, &sp);
+#endif
+}
+
+// ---------- stats ----------
+CycleExecutor::Stats CycleExecutor::stats() const {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    Stats s = stats_;
+    s.wake = wake_.get(s.cycles);
+    s.receive = receive_.get(s.cycles);
+    s.compute = compute_.get(s.cycles);
+    s.send = send_.get(s.cycles);
+    s.total = total_.get(s.cycles);
+    return s;
+}
+
+void CycleExecutor::resetStats() {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_ = Stats();
+    wake_ = receive_ = compute_ = send_ = total_ = PhaseAcc();
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "UdpDoubleReceiver.hpp"
+#include "UdpDoubleSender.hpp"
+#include "SteadyClock.hpp"
+
+// Closed-loop control cycle on one thread: receive, compute, send.
+//
+// Cycles start on an absolute steady_clock grid (start + k * period), so
+// sleep jitter never accumulates into drift. Each cycle takes the freshest
+// frame of every input, calls the step function, then sends every output
+// back to back. Receive / compute / send times and wake-up latency are
+// tracked per phase; a cycle whose work ends after its deadline is an
+// overrun, handled by the configured policy:
+//
+// - Skip:     drop the grid points that already passed, resume on the next
+// - CatchUp:  run the missed cycles back to back (up to maxCatchUp), then skip
+// - Degrade:  like Skip, and after degradeAfter overruns in a row run with
+//             Cycle::degraded set until recoverAfter clean cycles; the step
+//             function chooses a cheaper path and may leave optional outputs
+//             empty
+class CycleExecutor {
+public:
+    enum class OverrunPolicy { Skip, CatchUp, Degrade };
+
+    struct Config {
+        std::int64_t periodNanos = 4'000'000;
+        std::int64_t deadlineNanos = 0;    // work budget from the grid point; <= 0: period
+        OverrunPolicy policy = OverrunPolicy::Skip;
+        int maxCatchUp = 4;                // CatchUp: late cycles run back to back
+        int degradeAfter = 2;              // Degrade: overruns in a row to enter
+        int recoverAfter = 50;             // Degrade: clean cycles in a row to leave
+        std::int64_t spinNanos = 50'000;   // busy-wait the last part of each sleep
+        bool realtimePriority = false;     // raise the cycle thread (best effort)
+    };
+
+    // Freshest frame of one input as seen at the start of a cycle.
+    struct Input {
+        bool valid = false;                // something received yet
+        bool fresh = false;                // newer than in the previous cycle
+        std::int64_t ageNanos = 0;         // cycle start - arrival
+        UdpDoubleReceiver::Packet packet;
+    };
+
+    // What the step function sees. outputs[k] goes to addOutput() k; leave
+    // it empty to send nothing there this cycle.
+    struct Cycle {
+        std::uint64_t index = 0;           // grid point number
+        std::int64_t scheduledNanos = 0;   // grid point
+        std::int64_t startNanos = 0;       // actual wake-up
+        std::int64_t deadlineNanos = 0;
+        std::uint64_t missed = 0;          // grid points skipped before this one
+        bool catchingUp = false;           // run late, back to back
+        bool degraded = false;
+        std::vector<Input> inputs;
+        std::vector<std::vector<double>> outputs;
+    };
+    // Runs on the cycle thread; must not throw.
+    using Step = std::function<void(Cycle&)>;
+
+    struct Phase {
+        double meanNanos = 0.0;
+        std::int64_t maxNanos = 0;
+    };
+
+    struct Stats {
+        std::uint64_t cycles = 0;          // step calls
+        std::uint64_t overruns = 0;        // work ended after the deadline
+        std::uint64_t skipped = 0;         // grid points never run
+        std::uint64_t caughtUp = 0;        // cycles run late (CatchUp)
+        std::uint64_t degraded = 0;        // cycles run degraded
+        std::uint64_t staleInputs = 0;     // inputs without a new frame
+        std::uint64_t sendErrors = 0;
+        Phase wake;                        // grid point -> wake-up
+        Phase receive;
+        Phase compute;
+        Phase send;
+        Phase total;                       // wake-up -> last send
+    };
+
+    CycleExecutor(Step step, const Config& cfg);
+    explicit CycleExecutor(Step step);
+    ~CycleExecutor();
+
+    CycleExecutor(const CycleExecutor&) = delete;
+    CycleExecutor& operator=(const CycleExecutor&) = delete;
+
+    // Before start(); receivers / senders must outlive the executor.
+    // Return the input / output index.
+    int addInput(UdpDoubleReceiver& receiver, int source = 0);
+    int addOutput(UdpDoubleSender& sender, bool sparse = false);
+
+    bool start();
+    void stop();
+    bool isRunning() const { return running_.load(); }
+
+    // Runs cycles on the calling thread until stop() (from elsewhere) or
+    // after maxCycles step calls (0: no limit).
+    void run(std::uint64_t maxCycles = 0);
+
+    Stats stats() const;
+    void resetStats();
+
+    static std::int64_t nowNanos() { return SteadyClock::nowNanos(); }
+
+private:
+    struct Source {
+        UdpDoubleReceiver* receiver;
+        int source;
+    };
+    struct Sink {
+        UdpDoubleSender* sender;
+        bool sparse;
+    };
+    struct PhaseAcc {
+        double sum = 0.0;
+        std::int64_t max = 0;
+        void add(std::int64_t v) { sum += (double)v; if (v > max) max = v; }
+        Phase get(std::uint64_t n) const { return Phase{n ? sum / (double)n : 0.0, max}; }
+    };
+
+    void loop(std::uint64_t maxCycles);
+    void runCycle(std::int64_t scheduled, std::int64_t wake);
+    void waitUntil(std::int64_t t) const;
+    void setPriority(bool realtime);      // calling thread
+
+private:
+    const Step step_;
+    const Config cfg_;
+    const std::int64_t deadline_;
+
+    std::vector<Source> sources_;
+    std::vector<Sink> sinks_;
+    Cycle cycle_;
+
+    // cycle thread only
+    int overrunRun_ = 0;
+    int cleanRun_ = 0;
+    bool degradedMode_ = false;
+
+    mutable std::mutex statsMutex_;
+    Stats stats_;
+    PhaseAcc wake_, receive_, compute_, send_, total_;
+
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
@@ -0,0 +1,216 @@
+#include "FramePipeline.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+static constexpr int IDLE_SPINS = 64;                       // yields before parking
+static constexpr std::int64_t PARK_NANOS = 1000 * 1000;     // bounds a missed wakeup
+
+static void updateMax(std::atomic<std::int64_t>& m, std::int64_t v) {
+    std::int64_t cur = m.load(std::memory_order_relaxed);
+    while (v > cur && !m.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+}
+
+FramePipeline::FramePipeline(Handler handler, int workers, Mode mode, std::size_t maxDoubles, std::uint32_t depth)
+    : handler_(std::move(handler)),
+      mode_(mode),
+      pool_(maxDoubles, depth)
+{
+    if (!handler_ || workers <= 0) throw std::invalid_argument("FramePipeline needs a handler and workers");
+
+    // the pool bounds the total; per-worker queues may each take it all
+    const std::size_t queues = (mode_ == Mode::Shared) ? 1 : (std::size_t)workers;
+    for (std::size_t q = 0; q < queues; ++q) queues_.emplace_back(new MpmcQueue<Job>(depth));
+    for (int w = 0; w < workers; ++w) workers_.emplace_back(new Worker());
+}
+
+FramePipeline::~FramePipeline() {
+    stop();
+}
+
+bool FramePipeline::start() {
+    if (running_) return true;
+    running_ = true;
+    accepting_ = true;
+    for (std::size_t w = 0; w < workers_.size(); ++w)
+        workers_[w]->thread = std::thread(&FramePipeline::run, this, (int)w);
+    return true;
+}
+
+void FramePipeline::stop() {
+    if (!running_) return;
+    // a submit that saw accepting_ set is finishing its push; let it land
+    // before the workers may exit, so every frame is processed or dropped
+    accepting_ = false;
+    while (submitters_.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+    running_ = false;
+    wakeIdle();
+    for (auto& w : workers_)
+        if (w->thread.joinable()) w->thread.join();
+}
+
+// ---------- producer side ----------
+bool FramePipeline::submit(int stream, std::uint32_t seq, std::uint64_t timestampNanos, std::int64_t arrivalNanos,
+                           const double* data, std::size_t count) {
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    // seq_cst pairs with stop(): either it waits for us or we see accepting_ clear
+    submitters_.fetch_add(1, std::memory_order_seq_cst);
+    const bool queued = enqueue(stream, seq, timestampNanos, arrivalNanos, data, count);
+    submitters_.fetch_sub(1, std::memory_order_release);
+    return queued;
+}
+
+bool FramePipeline::enqueue(int stream, std::uint32_t seq, std::uint64_t timestampNanos, std::int64_t arrivalNanos,
+                            const double* data, std::size_t count) {
+    if (!accepting_.load(std::memory_order_seq_cst) || count > pool_.maxDoubles()) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Job job;
+    job.frame = pool_.acquire();
+    if (!job.frame) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    FramePool::FrameHeader& h = job.frame.header();
+    h.seq = seq;
+    h.count = (std::uint16_t)count;
+    h.timestampNanos = timestampNanos;
+    std::copy(data, data + count, job.frame.data());
+    job.stream = stream;
+    job.arrivalNanos = arrivalNanos;
+    job.enqueuedNanos = nowNanos();
+
+    std::size_t q = 0;
+    if (mode_ == Mode::WorkStealing) {
+        q = nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    } else if (mode_ == Mode::OrderedByStream) {
+        q = (std::size_t)(stream < 0 ? -stream : stream) % queues_.size();
+    }
+
+    // count before publishing so a fast worker never sees depth underflow
+    const std::size_t d = depth_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (!queues_[q]->tryPush(std::move(job))) {
+        depth_.fetch_sub(1, std::memory_order_relaxed);
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;   // job (and its frame) released here
+    }
+    std::size_t m = maxDepth_.load(std::memory_order_relaxed);
+    while (d > m && !maxDepth_.compare_exchange_weak(m, d, std::memory_order_relaxed)) {}
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);   // pairs with run(): push vs. sleepers_
+    if (sleepers_.load(std::memory_order_relaxed) > 0) wakeIdle();
+    return true;
+}
+
+void FramePipeline::wakeIdle() {
+    std::lock_guard<std::mutex> lock(idleMutex_);
+    idleCv_.notify_all();
+}
+
+// ---------- workers ----------
+bool FramePipeline::anyQueued(int w) const {
+    if (mode_ == Mode::OrderedByStream) return queues_[(std::size_t)w]->sizeApprox() > 0;
+    return depth_.load(std::memory_order_relaxed) > 0;
+}
+
+bool FramePipeline::take(int w, Job& job) {
+    const std::size_t n = queues_.size();
+    const std::size_t own = (n == 1) ? 0 : (std::size_t)w;
+    if (queues_[own]->tryPop(job)) return true;
+    if (mode_ != Mode::WorkStealing) return false;
+
+    for (std::size_t k = 1; k < n; ++k) {
+        if (queues_[(own + k) % n]->tryPop(job)) {
+            workers_[(std::size_t)w]->steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void FramePipeline::run(int w) {
+    Worker& me = *workers_[(std::size_t)w];
+    int idle = 0;
+    Job job;
+
+    for (;;) {
+        if (take(w, job)) {
+            depth_.fetch_sub(1, std::memory_order_relaxed);
+            idle = 0;
+
+            const std::int64_t start = nowNanos();
+            const FramePool::FrameHeader& h = job.frame.header();
+            Item item;
+            item.stream = job.stream;
+            item.seq = h.seq;
+            item.timestampNanos = h.timestampNanos;
+            item.arrivalNanos = job.arrivalNanos;
+            item.data = job.frame.data();
+            item.count = h.count;
+            item.worker = w;
+            handler_(item);
+            const std::int64_t done = nowNanos();
+            job.frame.reset();
+
+            const std::int64_t queued = start - job.enqueuedNanos;
+            me.queueSum.fetch_add(queued, std::memory_order_relaxed);
+            updateMax(me.queueMax, queued);
+            me.serviceSum.fetch_add(done - start, std::memory_order_relaxed);
+            updateMax(me.serviceMax, done - start);
+            if (job.arrivalNanos > 0) me.endToEndSum.fetch_add(done - job.arrivalNanos, std::memory_order_relaxed);
+            me.processed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        // drain before exiting: stop() clears running_ only once no submit
+        // is between its accepting_ check and its push
+        if (!running_.load(std::memory_order_acquire) && !anyQueued(w)) break;
+
+        if (++idle < IDLE_SPINS) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(idleMutex_);
+        sleepers_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!anyQueued(w) && running_.load(std::memory_order_relaxed))
+            idleCv_.wait_for(lock, std::chrono::nanoseconds(PARK_NANOS));
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        idle = 0;
+    }
+}
+
+// ---------- stats ----------
+int FramePipeline::pressurePermille() const {
+    const std::size_t d = depth_.load(std::memory_order_relaxed);
+    return (int)std::min<std::size_t>(1000, d * 1000 / pool_.slotCount());
+}
+
+FramePipeline::Stats FramePipeline::stats() const {
+    Stats s;
+    s.submitted = submitted_.load(std::memory_order_relaxed);
+    s.dropped = dropped_.load(std::memory_order_relaxed);
+    s.queueDepth = depth_.load(std::memory_order_relaxed);
+    s.maxQueueDepth = maxDepth_.load(std::memory_order_relaxed);
+
+    double queueSum = 0.0, serviceSum = 0.0, e2eSum = 0.0;
+    for (const auto& w : workers_) {
+        s.processed += w->processed.load(std::memory_order_relaxed);
+        s.steals += w->steals.load(std::memory_order_relaxed);
+        queueSum += (double)w->queueSum.load(std::memory_order_relaxed);
+        serviceSum += (double)w->serviceSum.load(std::memory_order_relaxed);
+        e2eSum += (double)w->endToEndSum.load(std::memory_order_relaxed);
+        s.maxQueueNanos = std::max(s.maxQueueNanos, w->queueMax.load(std::memory_order_relaxed));
+        s.maxServiceNanos = std::max(s.maxServiceNanos, w->serviceMax.load(std::memory_order_relaxed));
+    }
+    if (s.processed) {
+        s.meanQueueNanos = queueSum / (double)s.processed;
+        s.meanServiceNanos = serviceSum / (double)s.processed;
+        s.meanEndToEndNanos = e2eSum / (double)s.processed;
+    }
+    return s;
+}
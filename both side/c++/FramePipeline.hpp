@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FramePool.hpp"
+#include "MpmcQueue.hpp"
+#include "SteadyClock.hpp"
+
+// Hands decoded frames from receiver threads to a pool of worker threads,
+// so heavy per-frame work (kinematics, collision checks, compression) does
+// not stall the receiver.
+//
+// submit() copies the frame into a FramePool slot and queues it on a
+// bounded lock-free MPMC queue; it never blocks and drops (counted) when
+// the pool or queue is full. Dispatch modes:
+//
+// - Shared:          one queue, any worker takes the next frame
+// - WorkStealing:    one queue per worker, filled round-robin; idle workers
+//                    steal from the others
+// - OrderedByStream: one queue per worker, stream s always goes to worker
+//                    s % workers, so each stream is handled in order
+class FramePipeline {
+public:
+    enum class Mode { Shared, WorkStealing, OrderedByStream };
+
+    // What a handler sees; data is valid for the duration of the call.
+    struct Item {
+        int stream = 0;
+        std::uint32_t seq = 0;
+        std::uint64_t timestampNanos = 0;  // sender timestamp
+        std::int64_t  arrivalNanos = 0;    // receiver steady_clock
+        const double* data = nullptr;
+        std::size_t   count = 0;
+        int worker = 0;
+    };
+    using Handler = std::function<void(const Item&)>;
+
+    struct Stats {
+        std::uint64_t submitted = 0;
+        std::uint64_t processed = 0;
+        std::uint64_t dropped = 0;         // pool or queue full
+        std::uint64_t steals = 0;
+        std::size_t   queueDepth = 0;      // frames waiting now
+        std::size_t   maxQueueDepth = 0;
+        double        meanQueueNanos = 0.0;    // submit -> handler start
+        std::int64_t  maxQueueNanos = 0;
+        double        meanServiceNanos = 0.0;  // handler run time
+        std::int64_t  maxServiceNanos = 0;
+        double        meanEndToEndNanos = 0.0; // arrival -> handler done
+    };
+
+    // maxDoubles: largest frame; depth: frames that may wait in total
+    FramePipeline(Handler handler, int workers, Mode mode = Mode::Shared,
+                  std::size_t maxDoubles = 172, std::uint32_t depth = 1024);
+    ~FramePipeline();
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    bool start();
+    // Stops accepting frames, lets the workers drain the queues, joins them.
+    void stop();
+    bool isRunning() const { return running_.load(); }
+
+    // Any thread. False if the frame was dropped.
+    bool submit(int stream, std::uint32_t seq, std::uint64_t timestampNanos, std::int64_t arrivalNanos,
+                const double* data, std::size_t count);
+
+    Stats stats() const;
+    // Queued frames relative to the pipeline depth, 0..1000 (cheap).
+    int pressurePermille() const;
+    int workers() const { return (int)workers_.size(); }
+    Mode mode() const { return mode_; }
+
+    static std::int64_t nowNanos() { return SteadyClock::nowNanos(); }
+
+private:
+    struct Job {
+        FramePool::Frame frame;
+        int stream = 0;
+        std::int64_t arrivalNanos = 0;
+        std::int64_t enqueuedNanos = 0;
+    };
+
+    // per-worker counters, written by that worker only
+    struct alignas(FramePool::CACHE_LINE) Worker {
+        std::thread thread;
+        std::atomic<std::uint64_t> processed{0};
+        std::atomic<std::uint64_t> steals{0};
+        std::atomic<std::int64_t>  queueSum{0};
+        std::atomic<std::int64_t>  queueMax{0};
+        std::atomic<std::int64_t>  serviceSum{0};
+        std::atomic<std::int64_t>  serviceMax{0};
+        std::atomic<std::int64_t>  endToEndSum{0};
+    };
+
+    // submit() without the bookkeeping stop() waits on
+    bool enqueue(int stream, std::uint32_t seq, std::uint64_t timestampNanos, std::int64_t arrivalNanos,
+                 const double* data, std::size_t count);
+    void run(int w);
+    bool take(int w, Job& job);
+    bool anyQueued(int w) const;      // frames worker w could take
+    void wakeIdle();
+
+private:
+    const Handler handler_;
+    const Mode mode_;
+    FramePool pool_;
+
+    std::vector<std::unique_ptr<MpmcQueue<Job>>> queues_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<std::uint32_t> nextQueue_{0};       // WorkStealing round-robin
+
+    std::atomic<std::size_t> depth_{0};
+    std::atomic<std::size_t> maxDepth_{0};
+    std::atomic<std::uint64_t> submitted_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+
+    // idle workers park here; submit() only notifies when someone sleeps
+    std::mutex idleMutex_;
+    std::condition_variable idleCv_;
+    std::atomic<int> sleepers_{0};
+
+    std::atomic<bool> accepting_{false};
+    std::atomic<bool> running_{false};
+    std::atomic<int> submitters_{0};                // inside submit(); stop() waits for 0
+};
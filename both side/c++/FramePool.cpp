@@ -0,0 +1,305 @@
+#include "FramePool.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+#endif
+
+// ---------- per-thread caches ----------
+//
+// Each thread keeps a few indices per pool so the hot acquire/release path
+// does not touch the shared head. Only threads that acquire from a pool
+// cache its slots: a thread that only releases (pipeline workers, the
+// transmit dispatcher) would strand them, so it returns them to the shared
+// list. Caches are flushed back on thread exit if the pool is still alive
+// (checked through a small registry; both thread exit and pool destruction
+// are rare).
+
+namespace {
+
+constexpr int CACHE_POOLS = 4;            // pools cached per thread
+constexpr std::uint32_t CACHE_SLOTS = 16; // indices per pool
+constexpr std::uint32_t CACHE_BATCH = 8;  // refill / flush granularity
+constexpr std::uint32_t MIN_SLOTS_FOR_CACHE = 8 * CACHE_SLOTS;
+
+std::atomic<std::uint64_t> g_nextPoolId{1};
+
+std::mutex& registryMutex() {
+    static std::mutex m;
+    return m;
+}
+
+std::vector<std::pair<const FramePool*, std::uint64_t>>& registry() {
+    static std::vector<std::pair<const FramePool*, std::uint64_t>> r;
+    return r;
+}
+
+bool isLive(const FramePool* p, std::uint64_t id) {
+    for (const auto& e : registry())
+        if (e.first == p && e.second == id) return true;
+    return false;
+}
+
+} // namespace
+
+struct FramePool::ThreadCache {
+    struct Entry {
+        FramePool* pool = nullptr;
+        std::uint64_t id = 0;
+        std::uint32_t count = 0;
+        std::uint32_t idx[CACHE_SLOTS];
+    };
+    Entry entries[CACHE_POOLS];
+
+    // Existing entry only (release path).
+    Entry* lookup(FramePool* pool) {
+        for (auto& e : entries)
+            if (e.pool == pool && e.id == pool->id_) return &e;
+        return nullptr;
+    }
+
+    Entry* find(FramePool* pool) {
+        Entry* freeEntry = nullptr;
+        for (auto& e : entries) {
+            if (e.pool == pool && e.id == pool->id_) return &e;
+            if (e.pool == pool) { e = Entry{}; }         // stale: pool died, address reused
+            if (!e.pool && !freeEntry) freeEntry = &e;
+        }
+        if (!freeEntry) {
+            // reclaim entries of pools that have been destroyed
+            std::lock_guard<std::mutex> lock(registryMutex());
+            for (auto& e : entries) {
+                if (!isLive(e.pool, e.id)) { e = Entry{}; if (!freeEntry) freeEntry = &e; }
+            }
+        }
+        if (freeEntry) {
+            freeEntry->pool = pool;
+            freeEntry->id = pool->id_;
+            freeEntry->count = 0;
+        }
+        return freeEntry;   // nullptr: bypass cache
+    }
+
+    ~ThreadCache() {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for (auto& e : entries) {
+            if (!e.pool || !isLive(e.pool, e.id)) continue;
+            for (std::uint32_t i = 0; i < e.count; ++i) e.pool->pushGlobal(e.idx[i]);
+        }
+    }
+};
+
+FramePool::ThreadCache& FramePool::threadCache() {
+    thread_local ThreadCache cache;
+    return cache;
+}
+
+// ---------- Frame ----------
+FramePool::Frame& FramePool::Frame::operator=(Frame&& o) noexcept {
+    if (this != &o) {
+        reset();
+        pool_ = o.pool_;
+        index_ = o.index_;
+        o.pool_ = nullptr;
+        o.index_ = NO_SLOT;
+    }
+    return *this;
+}
+
+FramePool::FrameHeader& FramePool::Frame::header() const {
+    return *reinterpret_cast<FrameHeader*>(pool_->slotPtr(index_));
+}
+
+double* FramePool::Frame::data() const {
+    return reinterpret_cast<double*>(pool_->slotPtr(index_) + CACHE_LINE);
+}
+
+std::size_t FramePool::Frame::capacity() const {
+    return pool_ ? pool_->maxDoubles_ : 0;
+}
+
+void FramePool::Frame::reset() {
+    if (pool_) {
+        pool_->release(index_);
+        pool_ = nullptr;
+        index_ = NO_SLOT;
+    }
+}
+
+// ---------- ctor/dtor ----------
+FramePool::FramePool(std::size_t maxDoubles, std::uint32_t slotCount, bool tryHugePages)
+    : maxDoubles_(maxDoubles),
+      slotCount_(slotCount),
+      id_(g_nextPoolId.fetch_add(1, std::memory_order_relaxed))
+{
+    static_assert(sizeof(FrameHeader) <= CACHE_LINE, "header must fit one cache line");
+    if (slotCount_ == 0 || slotCount_ >= NO_SLOT)
+        throw std::invalid_argument("FramePool: slotCount out of range");
+
+    // header line + payload, rounded up to whole cache lines
+    const std::size_t payload = maxDoubles_ * sizeof(double);
+    slotBytes_ = CACHE_LINE + ((payload + CACHE_LINE - 1) / CACHE_LINE) * CACHE_LINE;
+
+    allocateArena(tryHugePages);
+
+    next_ = new std::atomic<std::uint32_t>[slotCount_];
+    for (std::uint32_t i = 0; i < slotCount_; ++i) {
+        next_[i].store((i + 1 < slotCount_) ? i + 1 : NO_SLOT, std::memory_order_relaxed);
+        new (slotPtr(i)) FrameHeader();
+    }
+    head_.store(0, std::memory_order_relaxed);   // tag 0, index 0
+
+    std::lock_guard<std::mutex> lock(registryMutex());
+    registry().emplace_back(this, id_);
+}
+
+FramePool::~FramePool() {
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        auto& r = registry();
+        r.erase(std::remove(r.begin(), r.end(), std::make_pair((const FramePool*)this, id_)), r.end());
+    }
+    delete[] next_;
+    next_ = nullptr;
+    freeArena();
+}
+
+// ---------- arena ----------
+void FramePool::allocateArena(bool tryHugePages) {
+    const std::size_t bytes = slotBytes_ * slotCount_;
+
+#if defined(_WIN32)
+    if (tryHugePages) {
+        // needs SeLockMemoryPrivilege; fails otherwise
+        const SIZE_T large = GetLargePageMinimum();
+        if (large > 0) {
+            const std::size_t rounded = ((bytes + large - 1) / large) * large;
+            void* p = VirtualAlloc(nullptr, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (p) {
+                arena_ = static_cast<std::uint8_t*>(p);
+                arenaBytes_ = rounded;
+                hugePages_ = true;
+                return;
+            }
+        }
+    }
+    void* p = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!p) throw std::bad_alloc();
+    arena_ = static_cast<std::uint8_t*>(p);
+    arenaBytes_ = bytes;
+#else
+  #if defined(MAP_HUGETLB)
+    if (tryHugePages) {
+        const std::size_t huge = 2u * 1024u * 1024u;
+        const std::size_t rounded = ((bytes + huge - 1) / huge) * huge;
+        void* p = mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            arena_ = static_cast<std::uint8_t*>(p);
+            arenaBytes_ = rounded;
+            hugePages_ = true;
+            return;
+        }
+    }
+  #endif
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) throw std::bad_alloc();
+  #if defined(MADV_HUGEPAGE)
+    if (tryHugePages) madvise(p, bytes, MADV_HUGEPAGE);   // transparent huge pages, best effort
+  #endif
+    arena_ = static_cast<std::uint8_t*>(p);
+    arenaBytes_ = bytes;
+#endif
+}
+
+void FramePool::freeArena() {
+    if (!arena_) return;
+#if defined(_WIN32)
+    VirtualFree(arena_, 0, MEM_RELEASE);
+#else
+    munmap(arena_, arenaBytes_);
+#endif
+    arena_ = nullptr;
+    arenaBytes_ = 0;
+}
+
+// ---------- global free list ----------
+std::uint32_t FramePool::popGlobal() {
+    std::uint64_t old = head_.load(std::memory_order_acquire);
+    for (;;) {
+        const std::uint32_t idx = std::uint32_t(old);
+        if (idx == NO_SLOT) return NO_SLOT;
+        const std::uint64_t tag = (old >> 32) + 1;
+        const std::uint64_t desired = (tag << 32) | next_[idx].load(std::memory_order_relaxed);
+        if (head_.compare_exchange_weak(old, desired, std::memory_order_acq_rel, std::memory_order_acquire))
+            return idx;
+    }
+}
+
+void FramePool::pushGlobal(std::uint32_t index) {
+    std::uint64_t old = head_.load(std::memory_order_relaxed);
+    for (;;) {
+        next_[index].store(std::uint32_t(old), std::memory_order_relaxed);
+        const std::uint64_t tag = (old >> 32) + 1;
+        const std::uint64_t desired = (tag << 32) | index;
+        if (head_.compare_exchange_weak(old, desired, std::memory_order_release, std::memory_order_relaxed))
+            return;
+    }
+}
+
+// ---------- acquire / release ----------
+FramePool::Frame FramePool::acquire() {
+    std::uint32_t idx = NO_SLOT;
+
+    ThreadCache::Entry* c = (slotCount_ >= MIN_SLOTS_FOR_CACHE) ? threadCache().find(this) : nullptr;
+    if (c) {
+        if (c->count == 0) {
+            while (c->count < CACHE_BATCH) {
+                const std::uint32_t g = popGlobal();
+                if (g == NO_SLOT) break;
+                c->idx[c->count++] = g;
+            }
+        }
+        if (c->count > 0) idx = c->idx[--c->count];
+    } else {
+        idx = popGlobal();
+    }
+
+    if (idx == NO_SLOT) {
+        exhausted_.fetch_add(1, std::memory_order_relaxed);
+        return Frame();
+    }
+
+    const std::uint32_t used = inUse_.fetch_add(1, std::memory_order_relaxed) + 1;
+    std::uint32_t hw = highWater_.load(std::memory_order_relaxed);
+    while (used > hw && !highWater_.compare_exchange_weak(hw, used, std::memory_order_relaxed)) {}
+
+    *reinterpret_cast<FrameHeader*>(slotPtr(idx)) = FrameHeader();
+    return Frame(this, idx);
+}
+
+void FramePool::release(std::uint32_t index) {
+    inUse_.fetch_sub(1, std::memory_order_relaxed);
+
+    // no entry: this thread never acquires here, so a cache would strand slots
+    ThreadCache::Entry* c = (slotCount_ >= MIN_SLOTS_FOR_CACHE) ? threadCache().lookup(this) : nullptr;
+    if (!c) {
+        pushGlobal(index);
+        return;
+    }
+    if (c->count == CACHE_SLOTS) {
+        for (std::uint32_t i = 0; i < CACHE_BATCH; ++i) pushGlobal(c->idx[--c->count]);
+    }
+    c->idx[c->count++] = index;
+}
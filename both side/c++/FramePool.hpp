@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-size frame storage for anything that buffers beyond "latest"
+// (history, reordering, async send, journaling).
+//
+// - one contiguous arena, slots are cache-line aligned
+// - arena is huge-page backed when the OS allows it (falls back silently)
+// - lock-free free list (tagged index, no ABA) + small per-thread caches
+// - acquire/release never allocate
+class FramePool {
+public:
+    static constexpr std::size_t CACHE_LINE = 64;
+    static constexpr std::uint32_t NO_SLOT = 0xFFFFFFFFu;
+
+    // Slot header; doubles follow immediately (aligned to CACHE_LINE).
+    struct FrameHeader {
+        std::uint32_t seq = 0;
+        std::uint16_t count = 0;
+        std::uint16_t flags = 0;
+        std::uint64_t timestampNanos = 0;
+    };
+
+    // RAII handle. Move-only; returns the slot to the pool on destruction.
+    class Frame {
+    public:
+        Frame() = default;
+        Frame(const Frame&) = delete;
+        Frame& operator=(const Frame&) = delete;
+        Frame(Frame&& o) noexcept : pool_(o.pool_), index_(o.index_) { o.pool_ = nullptr; o.index_ = NO_SLOT; }
+        Frame& operator=(Frame&& o) noexcept;
+        ~Frame() { reset(); }
+
+        explicit operator bool() const { return pool_ != nullptr; }
+
+        FrameHeader& header() const;
+        double*      data() const;
+        std::size_t  capacity() const;   // max doubles per slot
+        std::uint32_t index() const { return index_; }
+
+        void reset();
+
+    private:
+        friend class FramePool;
+        Frame(FramePool* pool, std::uint32_t index) : pool_(pool), index_(index) {}
+
+        FramePool* pool_ = nullptr;
+        std::uint32_t index_ = NO_SLOT;
+    };
+
+    // maxDoubles: per-slot capacity (use the link's configured maxDoubles)
+    // slotCount:  number of frames (< NO_SLOT)
+    FramePool(std::size_t maxDoubles, std::uint32_t slotCount, bool tryHugePages = true);
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Returns an empty Frame when the pool is exhausted.
+    Frame acquire();
+
+    std::size_t   maxDoubles() const { return maxDoubles_; }
+    std::uint32_t slotCount() const { return slotCount_; }
+    std::size_t   slotBytes() const { return slotBytes_; }
+    bool          usesHugePages() const { return hugePages_; }
+
+    // Frames currently held by callers / the most ever held at once.
+    std::uint32_t inUse() const { return inUse_.load(std::memory_order_relaxed); }
+    std::uint32_t highWaterMark() const { return highWater_.load(std::memory_order_relaxed); }
+    // acquire() calls that found the pool empty
+    std::uint64_t exhaustedCount() const { return exhausted_.load(std::memory_order_relaxed); }
+
+private:
+    struct ThreadCache;
+
+    std::uint8_t* slotPtr(std::uint32_t index) const { return arena_ + std::size_t(index) * slotBytes_; }
+
+    void release(std::uint32_t index);
+
+    // global free list (Treiber stack on slot indices)
+    std::uint32_t popGlobal();
+    void pushGlobal(std::uint32_t index);
+
+    void allocateArena(bool tryHugePages);
+    void freeArena();
+
+    static ThreadCache& threadCache();
+
+private:
+    std::size_t maxDoubles_;
+    std::uint32_t slotCount_;
+    std::size_t slotBytes_ = 0;
+
+    std::uint8_t* arena_ = nullptr;
+    std::size_t arenaBytes_ = 0;
+    bool hugePages_ = false;
+
+    std::atomic<std::uint32_t>* next_ = nullptr;   // next_[i] = next free slot after i
+
+    // low 32 bits: head index, high 32 bits: ABA tag
+    alignas(CACHE_LINE) std::atomic<std::uint64_t> head_{0};
+
+    alignas(CACHE_LINE) std::atomic<std::uint32_t> inUse_{0};
+    std::atomic<std::uint32_t> highWater_{0};
+    std::atomic<std::uint64_t> exhausted_{0};
+
+    std::uint64_t id_;   // identifies this pool to thread caches (never reused)
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Bounded lock-free multi-producer / multi-consumer queue (Vyukov).
+//
+// Each cell carries a sequence number that says whose turn it is, so
+// producers and consumers only contend on their own counter and never
+// block each other. Capacity is rounded up to a power of two. T must be
+// default-constructible and movable; values are moved in and out.
+template <typename T>
+class MpmcQueue {
+public:
+    static constexpr std::size_t CACHE_LINE = 64;
+
+    explicit MpmcQueue(std::size_t capacity) {
+        if (capacity < 2) capacity = 2;
+        std::size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        cells_.reset(new Cell[cap]);
+        mask_ = cap - 1;
+        for (std::size_t i = 0; i < cap; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    // False (v untouched) when full.
+    bool tryPush(T&& v) {
+        std::size_t pos = enq_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells_[pos & mask_];
+            const std::size_t seq = c.seq.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)pos;
+            if (diff == 0) {
+                if (enq_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.value = std::move(v);
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enq_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // False when empty.
+    bool tryPop(T& out) {
+        std::size_t pos = deq_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells_[pos & mask_];
+            const std::size_t seq = c.seq.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)(pos + 1);
+            if (diff == 0) {
+                if (deq_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(c.value);
+                    c.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = deq_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+    // Racy snapshot; exact only when nobody is pushing or popping.
+    std::size_t sizeApprox() const {
+        const std::size_t e = enq_.load(std::memory_order_relaxed);
+        const std::size_t d = deq_.load(std::memory_order_relaxed);
+        return (e > d) ? e - d : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> seq{0};
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t mask_ = 0;
+    alignas(CACHE_LINE) std::atomic<std::size_t> enq_{0};
+    alignas(CACHE_LINE) std::atomic<std::size_t> deq_{0};
+};
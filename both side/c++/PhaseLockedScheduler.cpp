@@ -0,0 +1,134 @@
+#include "PhaseLockedScheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+static constexpr std::uint32_t LOCK_AFTER = 20;      // consecutive good observations
+static constexpr double GOOD_ERROR_FRACTION = 0.05;  // |filtered err| < 5% of period
+static constexpr double LOSE_ERROR_FRACTION = 0.25;  // |filtered err| > 25% drops lock
+static constexpr double LOCK_FILTER = 0.05;          // EWMA weight for lock detection
+static constexpr double MAX_PERIOD_DEVIATION = 0.2;  // period estimate within +-20% of nominal
+
+PhaseLockedScheduler::PhaseLockedScheduler(std::int64_t nominalPeriodNanos, std::int64_t leadNanos)
+    : nominalPeriod_(std::max<std::int64_t>(1, nominalPeriodNanos)),
+      lead_(leadNanos),
+      period_((double)nominalPeriod_)
+{
+    stats_.periodNanos = period_;
+}
+
+void PhaseLockedScheduler::observe(std::int64_t arrivalNanos) {
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    if (!started_) {
+        started_ = true;
+        origin_ = arrivalNanos;
+        phase_ = 0.0;
+        ++stats_.observations;
+        return;
+    }
+
+    const double t = (double)(arrivalNanos - origin_);
+    const double cycles = std::llround((t - phase_) / period_);
+    if (cycles < 1) return;   // same cycle again (duplicate / burst)
+
+    const double predicted = phase_ + cycles * period_;
+    const double err = t - predicted;
+
+    // PI loop: frequency from ki, phase from kp.
+    period_ += ki_ * err / cycles;
+    const double lo = nominalPeriod_ * (1.0 - MAX_PERIOD_DEVIATION);
+    const double hi = nominalPeriod_ * (1.0 + MAX_PERIOD_DEVIATION);
+    period_ = std::min(hi, std::max(lo, period_));
+    phase_ = predicted + kp_ * err;
+
+    ++stats_.observations;
+    stats_.skippedCycles += (std::uint64_t)(cycles - 1);
+    stats_.periodNanos = period_;
+
+    // Lock detection on the filtered error so receive-poll jitter does not
+    // keep the loop from ever declaring lock.
+    filteredErr_ += LOCK_FILTER * (err - filteredErr_);
+    stats_.filteredErrorNanos = filteredErr_;
+    const double absErr = std::fabs(filteredErr_);
+    if (absErr < GOOD_ERROR_FRACTION * period_) {
+        if (++goodInARow_ >= LOCK_AFTER && !locked_) {
+            locked_ = true;
+            errSum_ = errSqSum_ = 0.0;
+            lockedSamples_ = 0;
+            stats_.maxAbsErrorNanos = 0;
+        }
+    } else {
+        goodInARow_ = 0;
+        if (absErr > LOSE_ERROR_FRACTION * period_) locked_ = false;
+    }
+    stats_.locked = locked_;
+
+    updateStatsLocked(err);
+}
+
+void PhaseLockedScheduler::updateStatsLocked(double err) {
+    if (!locked_) {
+        // acquisition: short EWMA so the numbers reflect the current state
+        const double a = 0.1;
+        stats_.meanErrorNanos += a * (err - stats_.meanErrorNanos);
+        const double rms2 = stats_.rmsErrorNanos * stats_.rmsErrorNanos;
+        stats_.rmsErrorNanos = std::sqrt(rms2 + a * (err * err - rms2));
+        return;
+    }
+    ++lockedSamples_;
+    errSum_ += err;
+    errSqSum_ += err * err;
+    stats_.meanErrorNanos = errSum_ / (double)lockedSamples_;
+    stats_.rmsErrorNanos = std::sqrt(errSqSum_ / (double)lockedSamples_);
+    stats_.maxAbsErrorNanos = std::max(stats_.maxAbsErrorNanos, (std::int64_t)std::llround(std::fabs(err)));
+}
+
+std::int64_t PhaseLockedScheduler::nextSendTime(std::int64_t nowNanos) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    if (!started_) return nowNanos + nominalPeriod_;
+
+    const double period = locked_ ? period_ : (double)nominalPeriod_;
+    const double now = (double)(nowNanos - origin_);
+    // first robot cycle whose send instant (cycle - lead) lies after now
+    const double j = std::floor((now + (double)lead_ - phase_) / period) + 1.0;
+    const double sendAt = phase_ + j * period - (double)lead_;
+    return origin_ + (std::int64_t)std::llround(sendAt);
+}
+
+void PhaseLockedScheduler::setLead(std::int64_t leadNanos) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    lead_ = leadNanos;
+}
+
+void PhaseLockedScheduler::setGains(double kp, double ki) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    kp_ = std::min(1.0, std::max(0.0, kp));
+    ki_ = std::min(1.0, std::max(0.0, ki));
+}
+
+bool PhaseLockedScheduler::isLocked() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return locked_;
+}
+
+PhaseLockedScheduler::Stats PhaseLockedScheduler::stats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stats_;
+}
+
+void PhaseLockedScheduler::reset() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    started_ = false;
+    locked_ = false;
+    goodInARow_ = 0;
+    filteredErr_ = 0.0;
+    period_ = (double)nominalPeriod_;
+    phase_ = 0.0;
+    stats_ = Stats();
+    stats_.periodNanos = period_;
+    errSum_ = errSqSum_ = 0.0;
+    lockedSamples_ = 0;
+}
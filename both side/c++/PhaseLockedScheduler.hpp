@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+#include "SteadyClock.hpp"
+
+// Phase-locks the PC's send schedule to the robot's cycle.
+//
+// Feed observe() with the local arrival time of every frame the robot sends
+// once per cycle (status / echo stream, Packet::arrivalNanos). A second-order
+// PLL tracks the robot's period and phase; nextSendTime() then returns the
+// instant that puts the next frame lead nanoseconds ahead of the robot's
+// next cycle, so it is consumed with a small, stable age.
+//
+// Until locked, nextSendTime() free-runs at the nominal period.
+// Arrival stamps include the receiver's poll latency; the loop filters the
+// jitter, and a constant offset is absorbed by lead.
+class PhaseLockedScheduler {
+public:
+    struct Stats {
+        std::uint64_t observations = 0;
+        std::uint64_t skippedCycles = 0;    // robot frames we never saw
+        double periodNanos = 0.0;           // current period estimate
+        double meanErrorNanos = 0.0;        // phase error: arrival - prediction
+        double rmsErrorNanos = 0.0;
+        std::int64_t maxAbsErrorNanos = 0;  // since lock
+        double filteredErrorNanos = 0.0;    // smoothed phase offset (jitter removed)
+        bool locked = false;
+    };
+
+    // nominalPeriodNanos: robot cycle, e.g. 4'000'000 for a 4 ms task
+    // leadNanos: how far before the robot's cycle a frame should arrive
+    PhaseLockedScheduler(std::int64_t nominalPeriodNanos, std::int64_t leadNanos);
+
+    void observe(std::int64_t arrivalNanos);
+
+    // Next send instant strictly after nowNanos (steady_clock nanos).
+    std::int64_t nextSendTime(std::int64_t nowNanos) const;
+
+    void setLead(std::int64_t leadNanos);
+    // Loop gains: phase (kp) and frequency (ki) correction per observation.
+    void setGains(double kp, double ki);
+
+    bool  isLocked() const;
+    Stats stats() const;
+    void  reset();
+
+    static std::int64_t nowNanos() { return SteadyClock::nowNanos(); }
+
+private:
+    void updateStatsLocked(double err);
+
+private:
+    mutable std::mutex mtx_;
+
+    const std::int64_t nominalPeriod_;
+    std::int64_t lead_;
+    double kp_ = 0.1;
+    double ki_ = 0.002;
+
+    bool   started_ = false;
+    std::int64_t origin_ = 0; // first observation; phase_ is relative to it
+    double period_;           // estimated robot period (ns)
+    double phase_ = 0.0;      // estimated time of the last robot cycle (ns)
+    double filteredErr_ = 0.0;
+    std::uint32_t goodInARow_ = 0;
+    bool   locked_ = false;
+
+    // phase error statistics (EWMA while unlocked, running once locked)
+    Stats stats_;
+    double errSum_ = 0.0;
+    double errSqSum_ = 0.0;
+    std::uint64_t lockedSamples_ = 0;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+
+// Clock and datagram source of a UdpDoubleReceiver run on the calling
+// thread (UdpDoubleReceiver::simulate). Normally the receiver uses its own
+// UDP socket and steady_clock; an implementation of this interface
+// replaces both, e.g. SimulatedIo (ReceiverSimulation.hpp) replays a trace
+// on a virtual clock. All calls come from the receiving thread.
+class ReceiverIo {
+public:
+    virtual ~ReceiverIo() = default;
+
+    // Current time, steady_clock nanos (or the virtual equivalent).
+    virtual std::int64_t now() = 0;
+
+    // Next pending datagram into buf (truncated to capacity): its byte
+    // count, 0 if none is pending yet, < 0 once the source is exhausted
+    // (the receive loop then returns).
+    virtual int receive(std::uint8_t* buf, std::size_t capacity, sockaddr_in& from) = 0;
+
+    // Replies (handshake, reports, bulk ACKs, clock sync).
+    virtual void send(const std::uint8_t* msg, std::size_t n, const sockaddr_in& to) = 0;
+
+    // Idle: returns once a datagram may be pending or at untilNanos.
+    virtual void waitReadable(std::int64_t untilNanos) = 0;
+
+    // Busy until untilNanos without receiving (release queue).
+    virtual void sleepUntil(std::int64_t untilNanos) = 0;
+};
@@ -0,0 +1,145 @@
+#include "ReceiverSimulation.hpp"
+#include "UdpWire.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+static const char TRACE_MAGIC[8] = {'U', 'D', 'P', 'T', 'R', 'C', '1', '\n'};
+
+namespace {
+
+constexpr std::size_t RECORD_HEADER = 8 + 4 + 2 + 4;
+
+} // namespace
+
+// ---------- trace files ----------
+TraceWriter::TraceWriter(const std::string& path) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) throw std::runtime_error("cannot create trace " + path);
+    std::fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC), file_);
+}
+
+TraceWriter::~TraceWriter() {
+    if (file_) std::fclose(file_);
+}
+
+void TraceWriter::append(std::int64_t timeNanos, const sockaddr_in& from, const std::uint8_t* p, std::size_t n) {
+    write(timeNanos, ntohl(from.sin_addr.s_addr), ntohs(from.sin_port), p, n);
+}
+
+void TraceWriter::append(const TraceDatagram& d) {
+    write(d.timeNanos, d.addr, d.port, d.bytes.data(), d.bytes.size());
+}
+
+void TraceWriter::write(std::int64_t timeNanos, std::uint32_t addr, std::uint16_t port,
+                        const std::uint8_t* p, std::size_t n) {
+    std::uint8_t head[RECORD_HEADER];
+    UdpWire::put64(head, (std::uint64_t)timeNanos);
+    UdpWire::put32(head + 8, addr);
+    UdpWire::put16(head + 12, port);
+    UdpWire::put32(head + 14, (std::uint32_t)n);
+    std::fwrite(head, 1, sizeof(head), file_);
+    std::fwrite(p, 1, n, file_);
+    ++written_;
+}
+
+void TraceWriter::flush() {
+    std::fflush(file_);
+}
+
+SimulatedIo::Source SimulatedIo::openTrace(const std::string& path) {
+    std::shared_ptr<std::FILE> file(std::fopen(path.c_str(), "rb"), [](std::FILE* f) { if (f) std::fclose(f); });
+    if (!file) throw std::runtime_error("cannot open trace " + path);
+    char magic[sizeof(TRACE_MAGIC)];
+    if (std::fread(magic, 1, sizeof(magic), file.get()) != sizeof(magic) ||
+        std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0)
+        throw std::runtime_error("not a trace: " + path);
+
+    return [file](TraceDatagram& d) {
+        std::uint8_t head[RECORD_HEADER];
+        if (std::fread(head, 1, sizeof(head), file.get()) != sizeof(head)) return false;
+        d.timeNanos = (std::int64_t)UdpWire::get64(head);
+        d.addr = UdpWire::get32(head + 8);
+        d.port = UdpWire::get16(head + 12);
+        d.bytes.resize(UdpWire::get32(head + 14));
+        return std::fread(d.bytes.data(), 1, d.bytes.size(), file.get()) == d.bytes.size();
+    };
+}
+
+std::vector<std::uint8_t> SimulatedIo::encodeFrame(std::uint32_t seq, std::uint64_t timestampNanos,
+                                                   const double* values, std::size_t count) {
+    std::vector<std::uint8_t> out(20 + count * 8);
+    UdpWire::put32(out.data(), 0x55445044u);   // "UDPD"
+    UdpWire::put16(out.data() + 4, 1);
+    UdpWire::put16(out.data() + 6, (std::uint16_t)count);
+    UdpWire::put32(out.data() + 8, seq);
+    UdpWire::put64(out.data() + 12, timestampNanos);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &values[i], 8);
+        UdpWire::put64(out.data() + 20 + i * 8, bits);
+    }
+    return out;
+}
+
+// ---------- virtual clock ----------
+SimulatedIo::SimulatedIo(Source source, std::int64_t drainNanos)
+    : source_(std::move(source)), drain_(std::max<std::int64_t>(0, drainNanos))
+{
+    if (!source_) throw std::invalid_argument("SimulatedIo needs a source");
+    if (peek()) clock_ = next_.timeNanos;   // the run starts at the first arrival
+}
+
+SimulatedIo::SimulatedIo(std::vector<TraceDatagram> trace, std::int64_t drainNanos)
+    : SimulatedIo([trace = std::move(trace), i = std::size_t(0)](TraceDatagram& d) mutable {
+          if (i >= trace.size()) return false;
+          d = trace[i++];
+          return true;
+      }, drainNanos)
+{
+}
+
+bool SimulatedIo::peek() {
+    if (haveNext_) return true;
+    if (done_) return false;
+    if (source_(next_)) {
+        haveNext_ = true;
+        return true;
+    }
+    done_ = true;
+    end_ = clock_ + drain_;
+    return false;
+}
+
+int SimulatedIo::receive(std::uint8_t* buf, std::size_t capacity, sockaddr_in& from) {
+    if (!peek()) return clock_ >= end_ ? -1 : 0;
+    if (next_.timeNanos > clock_) return 0;
+
+    const std::size_t n = std::min(capacity, next_.bytes.size());
+    std::memcpy(buf, next_.bytes.data(), n);
+    from = sockaddr_in{};
+    from.sin_family = AF_INET;
+    from.sin_addr.s_addr = htonl(next_.addr);
+    from.sin_port = htons(next_.port);
+    haveNext_ = false;
+    ++delivered_;
+    return (int)n;
+}
+
+void SimulatedIo::send(const std::uint8_t* msg, std::size_t n, const sockaddr_in& to) {
+    ++replies_;
+    if (sink_) sink_(clock_, to, msg, n);
+}
+
+void SimulatedIo::waitReadable(std::int64_t untilNanos) {
+    // jump to the next arrival, or to untilNanos if that comes first
+    if (peek() && next_.timeNanos < untilNanos) untilNanos = next_.timeNanos;
+    else if (done_) untilNanos = std::min(untilNanos, end_);
+    clock_ = std::max(clock_, untilNanos);
+}
+
+void SimulatedIo::sleepUntil(std::int64_t untilNanos) {
+    clock_ = std::max(clock_, untilNanos);
+}
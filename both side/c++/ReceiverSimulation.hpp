@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ReceiverIo.hpp"
+
+// Deterministic, accelerated runs of the receive pipeline.
+//
+// SimulatedIo feeds UdpDoubleReceiver::simulate() from a datagram trace on
+// a virtual clock: the clock jumps straight to the next datagram (or the
+// receiver's next housekeeping instant) instead of waiting, so an hour of
+// 1 kHz traffic replays in seconds. Nothing depends on wall time or thread
+// timing, so the same trace gives bit-for-bit the same results (stats,
+// stores, reorder output, reports) every run. Worker pipelines
+// (FramePipeline) still run on real threads.
+//
+// Traces are recorded from a live receiver (setTraceRecorder + TraceWriter),
+// written by tools, or generated on the fly through a Source callback.
+//
+// Trace file: "UDPTRC1\n", then per datagram (BE)
+//   i64 arrival nanos, u32 IPv4 address, u16 port, u32 length, bytes
+
+struct TraceDatagram {
+    std::int64_t timeNanos = 0;           // arrival
+    std::uint32_t addr = 0;               // sender IPv4, host order
+    std::uint16_t port = 0;
+    std::vector<std::uint8_t> bytes;
+};
+
+class TraceWriter {
+public:
+    // Throws std::runtime_error if path cannot be created.
+    explicit TraceWriter(const std::string& path);
+    ~TraceWriter();
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    void append(std::int64_t timeNanos, const sockaddr_in& from, const std::uint8_t* p, std::size_t n);
+    void append(const TraceDatagram& d);
+    void flush();
+
+    std::uint64_t written() const { return written_; }
+
+private:
+    void write(std::int64_t timeNanos, std::uint32_t addr, std::uint16_t port, const std::uint8_t* p, std::size_t n);
+
+private:
+    std::FILE* file_ = nullptr;
+    std::uint64_t written_ = 0;
+};
+
+class SimulatedIo : public ReceiverIo {
+public:
+    // Next datagram of the trace, in arrival order; false when done.
+    using Source = std::function<bool(TraceDatagram&)>;
+    // Replies of the receiver (handshake, reports, ACKs) at virtual time.
+    using Sink = std::function<void(std::int64_t timeNanos, const sockaddr_in& to, const std::uint8_t* p, std::size_t n)>;
+
+    // drainNanos: virtual time the receiver keeps running after the last
+    // datagram (release queue, reorder timeouts, reports).
+    explicit SimulatedIo(Source source, std::int64_t drainNanos = 0);
+    explicit SimulatedIo(std::vector<TraceDatagram> trace, std::int64_t drainNanos = 0);
+
+    // Streams a trace file. Throws std::runtime_error if it cannot be
+    // opened or is not a trace; a truncated tail ends the trace.
+    static Source openTrace(const std::string& path);
+
+    // Full big-endian "UDPD" frame, for synthetic traces.
+    static std::vector<std::uint8_t> encodeFrame(std::uint32_t seq, std::uint64_t timestampNanos,
+                                                 const double* values, std::size_t count);
+
+    void setSink(Sink sink) { sink_ = std::move(sink); }
+
+    std::uint64_t delivered() const { return delivered_; }
+    std::uint64_t replies() const { return replies_; }
+
+    // ReceiverIo
+    std::int64_t now() override { return clock_; }
+    int  receive(std::uint8_t* buf, std::size_t capacity, sockaddr_in& from) override;
+    void send(const std::uint8_t* msg, std::size_t n, const sockaddr_in& to) override;
+    void waitReadable(std::int64_t untilNanos) override;
+    void sleepUntil(std::int64_t untilNanos) override;
+
+private:
+    bool peek();   // loads next_; false once the source is done
+
+private:
+    Source source_;
+    Sink sink_;
+    TraceDatagram next_;
+    bool haveNext_ = false;
+    bool done_ = false;
+    std::int64_t clock_ = 0;
+    std::int64_t drain_ = 0;
+    std::int64_t end_ = 0;                // clock at which the run ends, once done_
+    std::uint64_t delivered_ = 0;
+    std::uint64_t replies_ = 0;
+};
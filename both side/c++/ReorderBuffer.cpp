@@ -0,0 +1,125 @@
+#include "ReorderBuffer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+ReorderBuffer::ReorderBuffer(Deliver deliver, std::size_t window, std::int64_t maxWaitNanos, std::size_t maxDoubles)
+    : deliver_(std::move(deliver)),
+      maxWait_(maxWaitNanos),
+      pool_(maxDoubles, (std::uint32_t)[&] { std::size_t w = 2; while (w < window) w <<= 1; return w; }())
+{
+    if (!deliver_) throw std::invalid_argument("ReorderBuffer needs a deliver callback");
+    ring_.resize(pool_.slotCount());
+    mask_ = pool_.slotCount() - 1;
+}
+
+void ReorderBuffer::deliver(Entry& e) {
+    const FramePool::FrameHeader& h = e.frame.header();
+    Item item;
+    item.seq = h.seq;
+    item.timestampNanos = h.timestampNanos;
+    item.arrivalNanos = e.arrivalNanos;
+    item.data = e.frame.data();
+    item.count = h.count;
+    deliver_(item);
+    e.frame.reset();
+    --stats_.buffered;
+    ++stats_.delivered;
+}
+
+void ReorderBuffer::releaseRun() {
+    while (stats_.buffered > 0) {
+        Entry& e = at(next_);
+        if (!e.frame || e.frame.header().seq != next_) break;
+        deliver(e);
+        ++next_;
+    }
+    armGap();
+}
+
+void ReorderBuffer::armGap() {
+    if (stats_.buffered == 0) {
+        gapDeadline_ = 0;
+        return;
+    }
+    // head is missing: the wait starts with the first frame behind the gap
+    for (std::uint32_t s = next_ + 1;; ++s) {
+        Entry& e = at(s);
+        if (e.frame && e.frame.header().seq == s) {
+            gapDeadline_ = e.arrivalNanos + maxWait_;
+            return;
+        }
+    }
+}
+
+void ReorderBuffer::skipGap(bool timedOut) {
+    if (timedOut) ++stats_.timeouts;
+    while (stats_.buffered > 0) {
+        Entry& e = at(next_);
+        if (e.frame && e.frame.header().seq == next_) break;
+        ++stats_.skipped;
+        ++next_;
+    }
+    releaseRun();
+}
+
+void ReorderBuffer::push(std::uint32_t seq, std::uint64_t timestampNanos, std::int64_t arrivalNanos,
+                         const double* data, std::size_t count) {
+    if (count > pool_.maxDoubles()) return;
+    if (!started_) {
+        started_ = true;
+        next_ = seq;
+        highest_ = seq;
+    }
+
+    const std::int32_t ahead = std::int32_t(seq - next_);
+    if (ahead < 0) {
+        ++stats_.late;
+        return;
+    }
+    if ((std::uint32_t)ahead > mask_) {
+        // beyond the window: release/skip until seq fits
+        ++stats_.overflows;
+        const std::uint32_t target = seq - mask_;
+        while (next_ != target && stats_.buffered > 0) {
+            Entry& e = at(next_);
+            if (e.frame && e.frame.header().seq == next_) deliver(e);
+            else ++stats_.skipped;
+            ++next_;
+        }
+        if (next_ != target) {
+            stats_.skipped += std::uint32_t(target - next_);
+            next_ = target;
+        }
+        // frames now at the head go out; the gap wait follows the new head
+        releaseRun();
+    }
+
+    Entry& e = at(seq);
+    if (e.frame && e.frame.header().seq == seq) {
+        ++stats_.duplicates;
+        return;
+    }
+    e.frame = pool_.acquire();   // never empty: one slot per ring entry
+    FramePool::FrameHeader& h = e.frame.header();
+    h.seq = seq;
+    h.count = (std::uint16_t)count;
+    h.timestampNanos = timestampNanos;
+    std::copy(data, data + count, e.frame.data());
+    e.arrivalNanos = arrivalNanos;
+    ++stats_.buffered;
+
+    if (std::int32_t(seq - highest_) < 0) ++stats_.reordered;
+    else highest_ = seq;
+
+    if (seq == next_ || gapDeadline_ == 0) releaseRun();
+    if (gapDeadline_ != 0 && maxWait_ <= 0) skipGap(true);
+}
+
+void ReorderBuffer::poll(std::int64_t nowNanos) {
+    while (gapDeadline_ != 0 && nowNanos >= gapDeadline_) skipGap(true);
+}
+
+void ReorderBuffer::flush() {
+    while (stats_.buffered > 0) skipGap(false);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "FramePool.hpp"
+
+// Bounded reorder window: turns a briefly reordered frame stream back into
+// seq order for consumers that keep history (logging, the time-series
+// store, filters).
+//
+// Frames are parked in a power-of-two ring indexed by seq & (window - 1)
+// and released in order as soon as the next expected seq is present.
+// A gap is waited for at most maxWaitNanos (counted from the arrival of
+// the first frame behind it), then skipped. Frames older than the release
+// point or duplicates are dropped; a seq beyond the window forces the
+// window forward. O(1) amortised per frame.
+//
+// Single thread: push() and poll() must be called from the same thread
+// (the receiver thread when attached with UdpDoubleReceiver::attachReorder).
+class ReorderBuffer {
+public:
+    struct Item {
+        std::uint32_t seq = 0;
+        std::uint64_t timestampNanos = 0;
+        std::int64_t  arrivalNanos = 0;
+        const double* data = nullptr;
+        std::size_t   count = 0;
+    };
+    using Deliver = std::function<void(const Item&)>;
+
+    struct Stats {
+        std::uint64_t delivered = 0;
+        std::uint64_t reordered = 0;       // arrived after a higher seq, delivered in order
+        std::uint64_t timeouts = 0;        // gaps given up on
+        std::uint64_t skipped = 0;         // seqs never delivered
+        std::uint64_t late = 0;            // behind the release point, dropped
+        std::uint64_t duplicates = 0;
+        std::uint64_t overflows = 0;       // seq beyond the window forced a skip
+        std::size_t   buffered = 0;        // waiting now
+    };
+
+    // window is rounded up to a power of two; maxDoubles bounds one frame
+    ReorderBuffer(Deliver deliver, std::size_t window, std::int64_t maxWaitNanos, std::size_t maxDoubles = 172);
+
+    ReorderBuffer(const ReorderBuffer&) = delete;
+    ReorderBuffer& operator=(const ReorderBuffer&) = delete;
+
+    void push(std::uint32_t seq, std::uint64_t timestampNanos, std::int64_t arrivalNanos,
+              const double* data, std::size_t count);
+
+    // Skips gaps that waited longer than maxWaitNanos at time nowNanos.
+    void poll(std::int64_t nowNanos);
+
+    // Releases everything buffered, skipping the gaps.
+    void flush();
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Entry {
+        FramePool::Frame frame;
+        std::int64_t arrivalNanos = 0;
+    };
+
+    Entry& at(std::uint32_t seq) { return ring_[seq & mask_]; }
+    void releaseRun();                      // delivers present frames from next_
+    void skipGap(bool timedOut);            // advances next_ to the next present frame
+    void armGap();                          // sets gapDeadline_ for a blocked head
+    void deliver(Entry& e);
+
+private:
+    const Deliver deliver_;
+    const std::int64_t maxWait_;
+    FramePool pool_;
+    std::vector<Entry> ring_;
+    std::uint32_t mask_;
+
+    bool started_ = false;
+    std::uint32_t next_ = 0;                // next seq to release
+    std::uint32_t highest_ = 0;             // highest seq pushed
+    std::int64_t gapDeadline_ = 0;          // 0: head not blocked
+    Stats stats_;
+};
@@ -0,0 +1,81 @@
+#include "SendRateController.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+SendRateController::SendRateController(UdpDoubleSender& sender, const Config& cfg)
+    : sender_(sender),
+      cfg_(cfg)
+{
+    if (cfg_.minRateHz <= 0.0 || cfg_.maxRateHz < cfg_.minRateHz)
+        throw std::invalid_argument("SendRateController: need 0 < minRateHz <= maxRateHz");
+    stats_.rateHz = cfg_.maxRateHz;
+    stats_.sparse = !cfg_.adaptEncoding;
+    sender_.setFullRefreshInterval(cfg_.adaptEncoding ? 1 : cfg_.sparseRefreshInterval);
+}
+
+size_t SendRateController::send(const double* data, int count) {
+    const std::int64_t now = nowNanos();
+    if (now >= nextPollNanos_) {
+        nextPollNanos_ = now + cfg_.pollIntervalNanos;
+        poll();
+    }
+
+    ++stats_.offered;
+    if (now < nextSendNanos_) {
+        ++stats_.skipped;
+        return 0;
+    }
+    // keep the long-run rate; a late frame does not earn a burst
+    const std::int64_t period = (std::int64_t)(1e9 / stats_.rateHz);
+    nextSendNanos_ = std::max(nextSendNanos_ + period, now + period / 2);
+
+    const size_t bytes = sender_.sendSparseAutoSeq(data, count);
+    ++stats_.sent;
+    return bytes;
+}
+
+void SendRateController::poll() {
+    UdpReport r;
+    while (sender_.pollReport(r)) onReport(r);
+}
+
+void SendRateController::onReport(const UdpReport& r) {
+    ++stats_.reports;
+    if (!haveReport_) {
+        haveReport_ = true;
+        last_ = r;
+        return;
+    }
+    if ((std::int32_t)(r.reportSeq - last_.reportSeq) <= 0) return;   // stale / reordered report
+
+    // counters are cumulative and wrap; work on deltas
+    const std::uint32_t got = r.received - last_.received;
+    const std::uint32_t lost = r.lost - last_.lost;
+    const std::uint32_t overwritten = r.overwritten - last_.overwritten;
+    last_ = r;
+
+    const double loss = (got + lost) ? (double)lost / (double)(got + lost) : 0.0;
+    const std::int64_t jitter = (std::int64_t)r.jitterMicros * 1000;
+    stats_.lastLoss = loss;
+    stats_.lastJitterNanos = jitter;
+    stats_.lastPressurePermille = r.pressurePermille;
+
+    // frames overwritten unread mean the consumer polls slower than we send
+    const bool lossy = loss > cfg_.targetLoss;
+    const bool unread = cfg_.throttleOnUnread && got > 0 && overwritten * 2 > got;
+    const bool congested = lossy || unread || jitter > cfg_.maxJitterNanos ||
+                           (int)r.pressurePermille > cfg_.maxPressurePermille;
+
+    if (congested) {
+        stats_.rateHz = std::max(cfg_.minRateHz, stats_.rateHz * cfg_.decrease);
+        ++stats_.decreases;
+    } else {
+        stats_.rateHz = std::min(cfg_.maxRateHz, stats_.rateHz + (cfg_.maxRateHz - cfg_.minRateHz) / cfg_.increaseSteps);
+    }
+    if (cfg_.adaptEncoding && stats_.sparse == lossy) {
+        stats_.sparse = !lossy;
+        sender_.setFullRefreshInterval(stats_.sparse ? cfg_.sparseRefreshInterval : 1);
+    }
+}
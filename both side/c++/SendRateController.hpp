@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+
+#include "UdpDoubleSender.hpp"
+#include "UdpReport.hpp"
+#include "SteadyClock.hpp"
+
+// Optional closed-loop control of a UdpDoubleSender from receiver reports.
+//
+// Frames go through send(); the controller drains reports from the sender's
+// socket and adapts, within the configured bounds:
+//
+// - rate: AIMD. Loss above target, jitter above limit or receiver queue
+//   pressure above limit cut the rate (at most once per report); otherwise
+//   it climbs back linearly. Frames offered faster than the current rate
+//   are skipped; they are state snapshots, the next one supersedes them.
+// - encoding: sparse frames while the link is clean (fewer bytes), full
+//   frames while it loses packets (a lost sparse update is only repaired by
+//   the next full refresh).
+//
+// Frames always go through the sender's sparse path; "full" mode sets its
+// refresh interval to 1, so the sparse baseline stays exact across switches.
+// Sparse mode relies on the receiver merging UDPS updates onto its last
+// full frame (UdpDoubleReceiver rebases on every newer full frame), so the
+// first update after a switch already applies.
+// Not thread-safe; use from the one thread that produces frames.
+class SendRateController {
+public:
+    struct Config {
+        double minRateHz = 50.0;
+        double maxRateHz = 1000.0;
+        double targetLoss = 0.01;              // lost / (received + lost) per report
+        std::int64_t maxJitterNanos = 2000000;
+        int maxPressurePermille = 500;
+        bool throttleOnUnread = false;         // also back off when most frames go unread
+        double decrease = 0.7;                 // rate *= decrease on congestion
+        double increaseSteps = 20.0;           // (max - min) / steps per clean report
+        bool adaptEncoding = true;
+        int sparseRefreshInterval = 50;        // full refresh period while sparse
+        std::int64_t pollIntervalNanos = 5000000;
+    };
+
+    struct Stats {
+        double rateHz = 0.0;
+        bool sparse = false;
+        std::uint64_t offered = 0;
+        std::uint64_t sent = 0;
+        std::uint64_t skipped = 0;             // over the current rate
+        std::uint64_t reports = 0;
+        std::uint64_t decreases = 0;
+        double lastLoss = 0.0;
+        std::int64_t lastJitterNanos = 0;
+        int lastPressurePermille = 0;
+    };
+
+    SendRateController(UdpDoubleSender& sender, const Config& cfg);
+
+    // Sends (full or sparse) unless over the current rate. Returns bytes
+    // sent, 0 if skipped.
+    size_t send(const double* data, int count);
+
+    // Drains pending reports and adapts; send() calls it every pollInterval.
+    void poll();
+
+    const Stats& stats() const { return stats_; }
+    const Config& config() const { return cfg_; }
+
+    static std::int64_t nowNanos() { return SteadyClock::nowNanos(); }
+
+private:
+    void onReport(const UdpReport& r);
+
+private:
+    UdpDoubleSender& sender_;
+    const Config cfg_;
+    Stats stats_;
+
+    std::int64_t nextSendNanos_ = 0;
+    std::int64_t nextPollNanos_ = 0;
+
+    bool haveReport_ = false;
+    UdpReport last_;
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+// SSE2: baseline on x86-64, opt-in on 32-bit x86 (/arch:SSE2, -msse2).
+// Code guarded by SIMD_SSE2 keeps a scalar fallback for other targets.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define SIMD_SSE2 1
+#endif
@@ -0,0 +1,150 @@
+#include "StateVector.hpp"
+#include "UdpDoubleSender.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include "Simd.hpp"
+
+static constexpr int SPIN_ATTEMPTS = 64;   // then yield between copy attempts
+
+StateVector::StateVector(int channels, const std::vector<Range>& ranges, double initial)
+    : channels_(channels), ranges_(ranges)
+{
+    if (channels <= 0) throw std::invalid_argument("StateVector needs channels > 0");
+
+    std::vector<Range> sorted = ranges_;
+    std::sort(sorted.begin(), sorted.end(), [](const Range& a, const Range& b) { return a.first < b.first; });
+    int next = 0;
+    for (const Range& r : sorted) {
+        if (r.first < 0 || r.count <= 0 || r.first + r.count > channels)
+            throw std::invalid_argument("StateVector range outside the channels");
+        if (r.first < next) throw std::invalid_argument("StateVector ranges overlap");
+        if (r.first > next) gaps_.push_back(Range{next, r.first - next});
+        next = r.first + r.count;
+    }
+    if (next < channels) gaps_.push_back(Range{next, channels - next});
+    initial_.assign((std::size_t)channels, initial);
+
+    // every range starts on its own cache line
+    const std::size_t perLine = CACHE_LINE / sizeof(double);
+    std::size_t total = perLine;   // alignment slack
+    for (const Range& r : ranges_) total += ((std::size_t)r.count + perLine - 1) / perLine * perLine;
+    arena_.assign(total, initial);
+
+    std::uintptr_t p = reinterpret_cast<std::uintptr_t>(arena_.data());
+    p = (p + CACHE_LINE - 1) & ~(std::uintptr_t)(CACHE_LINE - 1);
+    double* base = reinterpret_cast<double*>(p);
+
+    slots_.reset(new Slot[ranges_.size()]);
+    for (std::size_t i = 0; i < ranges_.size(); ++i) {
+        slots_[i].data = base;
+        base += ((std::size_t)ranges_[i].count + perLine - 1) / perLine * perLine;
+    }
+}
+
+StateVector::Slot& StateVector::slot(int r) const {
+    if (r < 0 || r >= (int)ranges_.size()) throw std::invalid_argument("StateVector: no such range");
+    return slots_[(std::size_t)r];
+}
+
+// ---------- producers ----------
+double* StateVector::beginWrite(int r) {
+    Slot& s = slot(r);
+    // single writer per range: no locked read-modify-write needed
+    s.seq.store(s.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return s.data;
+}
+
+void StateVector::endWrite(int r) {
+    Slot& s = slots_[(std::size_t)r];
+    s.seq.store(s.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void StateVector::write(int r, const double* values) {
+    double* dst = beginWrite(r);
+    std::memcpy(dst, values, sizeof(double) * (std::size_t)ranges_[(std::size_t)r].count);
+    endWrite(r);
+}
+
+void StateVector::write(int r, int offset, const double* values, int count) {
+    const Range& range = ranges_.at((std::size_t)r);
+    if (offset < 0 || count < 0 || offset + count > range.count)
+        throw std::invalid_argument("StateVector write outside the range");
+    double* dst = beginWrite(r);
+    std::memcpy(dst + offset, values, sizeof(double) * (std::size_t)count);
+    endWrite(r);
+}
+
+std::uint64_t StateVector::version(int r) const {
+    return slot(r).seq.load(std::memory_order_acquire) / 2;
+}
+
+// ---------- readers ----------
+std::uint64_t StateVector::copyRange(int r, double* dst) const {
+    const Slot& s = slots_[(std::size_t)r];
+    const std::size_t bytes = sizeof(double) * (std::size_t)ranges_[(std::size_t)r].count;
+    for (int attempt = 0;; ++attempt) {
+        const std::uint64_t before = s.seq.load(std::memory_order_acquire);
+        if ((before & 1) == 0) {
+            std::memcpy(dst, s.data, bytes);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) == before) return before / 2;
+        }
+        retries_.fetch_add(1, std::memory_order_relaxed);
+        if (attempt < SPIN_ATTEMPTS) {
+#if SIMD_SSE2
+            _mm_pause();
+#endif
+        } else {
+            std::this_thread::yield();   // the producer was preempted mid-write
+        }
+    }
+}
+
+void StateVector::snapshot(Snapshot& out) const {
+    const bool fresh = out.values.size() != (std::size_t)channels_ || out.versions.size() != ranges_.size();
+    if (fresh) {
+        out.values = initial_;
+        out.versions.assign(ranges_.size(), 0);
+    } else {
+        for (const Range& g : gaps_)
+            std::copy(initial_.begin() + g.first, initial_.begin() + g.first + g.count, out.values.begin() + g.first);
+    }
+
+    int changed = 0;
+    for (int r = 0; r < (int)ranges_.size(); ++r) {
+        const std::uint64_t before = out.versions[(std::size_t)r];
+        const std::uint64_t now = copyRange(r, out.values.data() + ranges_[(std::size_t)r].first);
+        out.versions[(std::size_t)r] = now;
+        if (fresh || now != before) ++changed;
+    }
+    out.changedRanges = changed;
+    out.takenNanos = nowNanos();
+    snapshots_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::size_t StateVector::send(UdpDoubleSender& sender, bool sparse, bool skipUnchanged) {
+    snapshot(tick_);
+    if (skipUnchanged && tick_.changedRanges == 0) {
+        unchangedSkips_.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    const std::size_t bytes = sparse ? sender.sendSparseAutoSeq(tick_.values.data(), channels_)
+                                     : sender.sendAutoSeq(tick_.values.data(), channels_);
+    sends_.fetch_add(1, std::memory_order_relaxed);
+    return bytes;
+}
+
+StateVector::Stats StateVector::stats() const {
+    Stats s;
+    s.snapshots = snapshots_.load(std::memory_order_relaxed);
+    s.retries = retries_.load(std::memory_order_relaxed);
+    s.sends = sends_.load(std::memory_order_relaxed);
+    s.unchangedSkips = unchangedSkips_.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "SteadyClock.hpp"
+
+class UdpDoubleSender;
+
+// Outgoing state vector shared by several producer threads.
+//
+// The channels are split into ranges (arm joints, gripper, conveyor I/O,
+// ...), each owned by one producer thread. A producer updates its range
+// without a lock: the range has its own version counter (seqlock style,
+// odd while a write is in progress) and its own cache lines, so producers
+// never touch each other's memory. The sender thread takes a snapshot each
+// tick, copying every range at one of its versions and retrying a range
+// that was written during the copy, and transmits it. Producers never
+// wait; the sender only retries for the length of one range write.
+//
+// Each range is consistent in itself (all values from the same write);
+// different ranges are independent. Channels outside every range keep
+// their initial value.
+class StateVector {
+public:
+    static constexpr std::size_t CACHE_LINE = 64;
+
+    struct Range {
+        int first = 0;
+        int count = 0;
+    };
+
+    struct Snapshot {
+        std::vector<double> values;           // channels()
+        std::vector<std::uint64_t> versions;  // per range: writes completed
+        int changedRanges = 0;                // written since the previous snapshot into this object
+        std::int64_t takenNanos = 0;
+    };
+
+    struct Stats {
+        std::uint64_t snapshots = 0;
+        std::uint64_t retries = 0;            // range copies repeated (written meanwhile)
+        std::uint64_t sends = 0;
+        std::uint64_t unchangedSkips = 0;     // send() with nothing new, skipped
+    };
+
+    // Ranges must lie in [0, channels) and must not overlap. Range ids are
+    // their index in `ranges`.
+    StateVector(int channels, const std::vector<Range>& ranges, double initial = 0.0);
+
+    StateVector(const StateVector&) = delete;
+    StateVector& operator=(const StateVector&) = delete;
+
+    int channels() const { return channels_; }
+    int rangeCount() const { return (int)ranges_.size(); }
+    Range range(int r) const { return ranges_.at((std::size_t)r); }
+
+    // Producer of range r only (one thread per range).
+    void write(int r, const double* values);                             // the whole range
+    void write(int r, int offset, const double* values, int count);      // part of it
+    // In-place update of the range's values; endWrite() publishes.
+    double* beginWrite(int r);
+    void endWrite(int r);
+
+    // Writes of range r completed so far. Any thread.
+    std::uint64_t version(int r) const;
+
+    // Any thread; never blocks producers.
+    void snapshot(Snapshot& out) const;
+
+    // Sender thread: snapshot, then sendAutoSeq (sparse: sendSparseAutoSeq).
+    // With skipUnchanged nothing is sent (returns 0) when no range was
+    // written since the previous send. Sender exceptions propagate.
+    std::size_t send(UdpDoubleSender& sender, bool sparse = false, bool skipUnchanged = false);
+    const Snapshot& lastSent() const { return tick_; }
+
+    Stats stats() const;
+
+    static std::int64_t nowNanos() { return SteadyClock::nowNanos(); }
+
+private:
+    // One per range, on its own cache line; data points into the arena at a
+    // cache-line boundary.
+    struct alignas(CACHE_LINE) Slot {
+        std::atomic<std::uint64_t> seq{0};    // 2 * writes, odd during a write
+        double* data = nullptr;
+    };
+
+    Slot& slot(int r) const;
+    // Copies range r at a stable version; returns that version.
+    std::uint64_t copyRange(int r, double* dst) const;
+
+private:
+    const int channels_;
+    std::vector<Range> ranges_;
+    std::vector<Range> gaps_;                 // channels outside every range
+    std::vector<double> initial_;
+
+    std::unique_ptr<Slot[]> slots_;
+    std::vector<double> arena_;
+
+    Snapshot tick_;                           // send() only
+
+    mutable std::atomic<std::uint64_t> snapshots_{0};
+    mutable std::atomic<std::uint64_t> retries_{0};
+    std::atomic<std::uint64_t> sends_{0};
+    std::atomic<std::uint64_t> unchangedSkips_{0};
+};
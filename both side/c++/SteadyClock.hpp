@@ -0,0 +1,13 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Monotonic time in nanoseconds: the time base of every *Nanos timestamp
+// taken on this machine (arrival, enqueue, deadlines).
+struct SteadyClock {
+    static std::int64_t nowNanos() {
+        using namespace std::chrono;
+        return (std::int64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+};
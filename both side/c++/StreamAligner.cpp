@@ -0,0 +1,105 @@
+#include "StreamAligner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+
+StreamAligner::StreamAligner(std::int64_t periodNanos, std::int64_t delayNanos)
+    : period_(periodNanos),
+      delay_(delayNanos)
+{
+    if (periodNanos <= 0 || delayNanos < 0) throw std::invalid_argument("StreamAligner needs period > 0, delay >= 0");
+}
+
+StreamAligner::~StreamAligner() {
+    stop();
+}
+
+int StreamAligner::addStream(const TimeSeriesStore& store, std::int64_t maxStaleNanos, std::int64_t offsetNanos) {
+    if (running_) throw std::logic_error("addStream after start");
+    streams_.push_back(Entry{&store, maxStaleNanos, offsetNanos, width_});
+    width_ += store.channels();
+
+    for (Snapshot& s : slots_) {
+        s.values.assign(width_, 0.0);
+        s.streams.assign(streams_.size(), StreamStatus());
+    }
+    return (int)streams_.size() - 1;
+}
+
+// ---------- publishing ----------
+bool StreamAligner::start() {
+    if (running_) return true;
+    running_ = true;
+    thread_ = std::thread(&StreamAligner::run, this);
+    return true;
+}
+
+void StreamAligner::stop() {
+    if (!running_) return;
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+}
+
+void StreamAligner::tick() {
+    publish(nowNanos());
+}
+
+void StreamAligner::run() {
+    std::int64_t next = nowNanos();
+    while (running_) {
+        publish(nowNanos());
+
+        // keep the grid; skip ticks we are too late for
+        next += period_;
+        const std::int64_t now = nowNanos();
+        if (next <= now) next += ((now - next) / period_ + 1) * period_;
+        std::this_thread::sleep_for(std::chrono::nanoseconds(next - now));
+    }
+}
+
+void StreamAligner::publish(std::int64_t now) {
+    Snapshot& snap = slots_[backIndex_];
+    const std::int64_t target = now - delay_;
+
+    snap.seq = ++seq_;
+    snap.targetNanos = target;
+    snap.publishNanos = now;
+    snap.allValid = true;
+
+    for (std::size_t k = 0; k < streams_.size(); ++k) {
+        const Entry& e = streams_[k];
+        StreamStatus& st = snap.streams[k];
+        double* out = snap.values.data() + e.offset;
+
+        // the store's rows are in the stream's time; shift the target into it
+        std::int64_t before = 0, after = 0;
+        st.valid = e.store->sampleAt(target + e.offsetNanos, out, before, after);
+        if (st.valid) {
+            before -= e.offsetNanos;
+            after -= e.offsetNanos;
+            st.skewNanos = (target - before <= after - target) ? target - before : target - after;
+            const std::int64_t newest = e.store->latestNanos() - e.offsetNanos;
+            st.stalenessNanos = now - newest;
+            st.stale = e.maxStale > 0 && st.stalenessNanos > e.maxStale;
+        } else {
+            std::fill(out, out + e.store->channels(), std::numeric_limits<double>::quiet_NaN());
+            st.skewNanos = 0;
+            st.stalenessNanos = 0;
+            st.stale = true;
+        }
+        snap.allValid = snap.allValid && st.valid && !st.stale;
+    }
+
+    backIndex_ = middle_.exchange(backIndex_ | SLOT_FRESH, std::memory_order_acq_rel) & SLOT_MASK;
+    hasData_.store(true, std::memory_order_release);
+}
+
+const StreamAligner::Snapshot* StreamAligner::latest() {
+    if (!hasData_.load(std::memory_order_acquire)) return nullptr;
+    if (middle_.load(std::memory_order_acquire) & SLOT_FRESH) {
+        frontIndex_ = middle_.exchange(frontIndex_, std::memory_order_acq_rel) & SLOT_MASK;
+    }
+    return &slots_[frontIndex_];
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "TimeSeriesStore.hpp"
+#include "SteadyClock.hpp"
+
+// Combines several streams into snapshots taken at one instant.
+//
+// Each stream is a TimeSeriesStore (usually attached to a receiver, so rows
+// are stamped with the local arrival time). Every period the aligner picks
+// a target time delayNanos in the past, samples every stream there with
+// linear interpolation, and publishes one snapshot whose values are the
+// streams' channels concatenated in addStream() order (fixed layout, see
+// offset()).
+//
+// Snapshots are triple-buffered: latest() is wait-free for one reader.
+// A delay of about one stream period lets most samples be interpolated
+// instead of held.
+class StreamAligner {
+public:
+    struct StreamStatus {
+        bool valid = false;                // target was inside the stream's history
+        bool stale = false;                // newest row older than maxStaleNanos
+        std::int64_t skewNanos = 0;        // target - nearest row used
+        std::int64_t stalenessNanos = 0;   // publish time - newest row
+    };
+
+    struct Snapshot {
+        std::uint64_t seq = 0;
+        std::int64_t targetNanos = 0;      // the common instant (steady_clock)
+        std::int64_t publishNanos = 0;
+        bool allValid = false;             // every stream valid and fresh
+        std::vector<double> values;
+        std::vector<StreamStatus> streams;
+    };
+
+    StreamAligner(std::int64_t periodNanos, std::int64_t delayNanos);
+    ~StreamAligner();
+
+    StreamAligner(const StreamAligner&) = delete;
+    StreamAligner& operator=(const StreamAligner&) = delete;
+
+    // Before start(). offsetNanos is subtracted from the stream's row times
+    // (known transport or sampling latency). Returns the stream id.
+    int addStream(const TimeSeriesStore& store, std::int64_t maxStaleNanos, std::int64_t offsetNanos = 0);
+
+    // First index of a stream's channels in Snapshot::values.
+    std::size_t offset(int stream) const { return streams_[(std::size_t)stream].offset; }
+    std::size_t width() const { return width_; }
+
+    // Publishes every periodNanos from a background thread.
+    bool start();
+    void stop();
+    bool isRunning() const { return running_.load(); }
+
+    // Publishes one snapshot now; for callers driving their own loop
+    // (not while started).
+    void tick();
+
+    // Newest snapshot, nullptr before the first one. Valid until the next
+    // call; one reader thread.
+    const Snapshot* latest();
+
+    static std::int64_t nowNanos() { return SteadyClock::nowNanos(); }
+
+private:
+    struct Entry {
+        const TimeSeriesStore* store;
+        std::int64_t maxStale;
+        std::int64_t offsetNanos;
+        std::size_t offset;                // into Snapshot::values
+    };
+
+    void run();
+    void publish(std::int64_t now);
+
+    static constexpr int SLOT_FRESH = 4;
+    static constexpr int SLOT_MASK = 3;
+
+private:
+    const std::int64_t period_;
+    const std::int64_t delay_;
+
+    std::vector<Entry> streams_;
+    std::size_t width_ = 0;
+    std::uint64_t seq_ = 0;
+
+    // triple buffer, as in UdpDoubleReceiver
+    Snapshot slots_[3];
+    int backIndex_ = 0;                    // publisher only
+    std::atomic<int> middle_{1};
+    int frontIndex_ = 2;                   // reader only
+    std::atomic<bool> hasData_{false};
+
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
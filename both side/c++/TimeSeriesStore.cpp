@@ -0,0 +1,238 @@
+#include "TimeSeriesStore.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "Simd.hpp"
+
+static constexpr int MAX_READ_ATTEMPTS = 8;   // writer lapped the reader this often: give up
+
+namespace {
+
+struct Acc {
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    double sum = 0.0;
+    double sumSq = 0.0;
+    std::size_t n = 0;
+};
+
+// Folds v[0..n) into a, skipping NaN.
+void accumulate(const double* v, std::size_t n, Acc& a) {
+    std::size_t i = 0;
+#if SIMD_SSE2
+    const __m128d inf = _mm_set1_pd(std::numeric_limits<double>::infinity());
+    const __m128d ninf = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+    const __m128d one = _mm_set1_pd(1.0);
+    __m128d vmin = inf, vmax = ninf;
+    __m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+    __m128d sq0 = _mm_setzero_pd(), sq1 = _mm_setzero_pd();
+    __m128d cnt = _mm_setzero_pd();
+
+    // two independent accumulators hide the add latency
+    for (; i + 4 <= n; i += 4) {
+        const __m128d x0 = _mm_loadu_pd(v + i);
+        const __m128d x1 = _mm_loadu_pd(v + i + 2);
+        const __m128d ok0 = _mm_cmpord_pd(x0, x0);
+        const __m128d ok1 = _mm_cmpord_pd(x1, x1);
+        const __m128d z0 = _mm_and_pd(ok0, x0);   // NaN -> 0
+        const __m128d z1 = _mm_and_pd(ok1, x1);
+
+        vmin = _mm_min_pd(vmin, _mm_or_pd(z0, _mm_andnot_pd(ok0, inf)));
+        vmin = _mm_min_pd(vmin, _mm_or_pd(z1, _mm_andnot_pd(ok1, inf)));
+        vmax = _mm_max_pd(vmax, _mm_or_pd(z0, _mm_andnot_pd(ok0, ninf)));
+        vmax = _mm_max_pd(vmax, _mm_or_pd(z1, _mm_andnot_pd(ok1, ninf)));
+        sum0 = _mm_add_pd(sum0, z0);
+        sum1 = _mm_add_pd(sum1, z1);
+        sq0 = _mm_add_pd(sq0, _mm_mul_pd(z0, z0));
+        sq1 = _mm_add_pd(sq1, _mm_mul_pd(z1, z1));
+        cnt = _mm_add_pd(cnt, _mm_add_pd(_mm_and_pd(ok0, one), _mm_and_pd(ok1, one)));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, vmin);
+    a.min = std::min(a.min, std::min(lanes[0], lanes[1]));
+    _mm_storeu_pd(lanes, vmax);
+    a.max = std::max(a.max, std::max(lanes[0], lanes[1]));
+    _mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+    a.sum += lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, _mm_add_pd(sq0, sq1));
+    a.sumSq += lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, cnt);
+    a.n += (std::size_t)(lanes[0] + lanes[1]);
+#endif
+    for (; i < n; ++i) {
+        const double x = v[i];
+        if (std::isnan(x)) continue;
+        a.min = std::min(a.min, x);
+        a.max = std::max(a.max, x);
+        a.sum += x;
+        a.sumSq += x * x;
+        ++a.n;
+    }
+}
+
+} // namespace
+
+TimeSeriesStore::TimeSeriesStore(std::size_t channels, std::size_t capacity)
+    : channels_(channels),
+      capacity_(capacity + 1)   // one spare row: the one being overwritten
+{
+    if (channels == 0 || capacity == 0) throw std::invalid_argument("TimeSeriesStore needs channels and capacity");
+    times_.assign(capacity_, 0);
+    values_.assign(channels_ * capacity_, std::numeric_limits<double>::quiet_NaN());
+}
+
+// ---------- writer ----------
+void TimeSeriesStore::append(std::int64_t timeNanos, const double* values, std::size_t count) {
+    const std::uint64_t h = head_.load(std::memory_order_relaxed);
+    writing_.store(h + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const std::size_t row = (std::size_t)(h % capacity_);
+    const std::size_t n = std::min(count, channels_);
+    times_[row] = timeNanos;
+    for (std::size_t c = 0; c < n; ++c) values_[c * capacity_ + row] = values[c];
+    for (std::size_t c = n; c < channels_; ++c) values_[c * capacity_ + row] = std::numeric_limits<double>::quiet_NaN();
+
+    head_.store(h + 1, std::memory_order_release);
+}
+
+// ---------- readers ----------
+std::size_t TimeSeriesStore::size() const {
+    return (std::size_t)std::min<std::uint64_t>(head_.load(std::memory_order_acquire), capacity_ - 1);
+}
+
+std::int64_t TimeSeriesStore::latestNanos() const {
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+        const std::uint64_t h = head_.load(std::memory_order_acquire);
+        if (h == 0) return 0;
+        const std::int64_t t = timeAt(h - 1);
+        if (stillValid(h - 1)) return t;
+    }
+    return 0;
+}
+
+bool TimeSeriesStore::stillValid(std::uint64_t first) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return first + capacity_ >= writing_.load(std::memory_order_relaxed);
+}
+
+std::uint64_t TimeSeriesStore::lowerBound(std::uint64_t lo, std::uint64_t hi, std::int64_t t) const {
+    while (lo < hi) {
+        const std::uint64_t mid = lo + (hi - lo) / 2;
+        if (timeAt(mid) < t) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void TimeSeriesStore::window(std::uint64_t head, std::int64_t fromNanos, std::int64_t toNanos,
+                             std::uint64_t& first, std::uint64_t& last) const {
+    const std::uint64_t oldest = (head >= capacity_) ? head - capacity_ + 1 : 0;
+    first = lowerBound(oldest, head, fromNanos);
+    last = (toNanos == std::numeric_limits<std::int64_t>::max()) ? head
+                                                                  : lowerBound(first, head, toNanos + 1);
+}
+
+std::size_t TimeSeriesStore::query(std::size_t channel, std::int64_t fromNanos, std::int64_t toNanos,
+                                   std::vector<std::int64_t>& times, std::vector<double>& values) const {
+    times.clear();
+    values.clear();
+    if (channel >= channels_ || toNanos < fromNanos) return 0;
+    const double* col = values_.data() + channel * capacity_;
+
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+        std::uint64_t first, last;
+        window(head_.load(std::memory_order_acquire), fromNanos, toNanos, first, last);
+
+        times.resize((std::size_t)(last - first));
+        values.resize((std::size_t)(last - first));
+        for (std::uint64_t r = first; r < last; ++r) {
+            const std::size_t row = (std::size_t)(r % capacity_);
+            times[(std::size_t)(r - first)] = times_[row];
+            values[(std::size_t)(r - first)] = col[row];
+        }
+        if (stillValid(first)) return times.size();
+    }
+    times.clear();
+    values.clear();
+    return 0;
+}
+
+bool TimeSeriesStore::aggregate(std::size_t channel, std::int64_t fromNanos, std::int64_t toNanos, Aggregate& out) const {
+    if (channel >= channels_ || toNanos < fromNanos) return false;
+    const double* col = values_.data() + channel * capacity_;
+
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+        std::uint64_t first, last;
+        window(head_.load(std::memory_order_acquire), fromNanos, toNanos, first, last);
+        if (first == last) return false;
+
+        // the window is at most two contiguous runs of the ring
+        Acc acc;
+        const std::size_t begin = (std::size_t)(first % capacity_);
+        const std::size_t rows = (std::size_t)(last - first);
+        const std::size_t run1 = std::min(rows, capacity_ - begin);
+        accumulate(col + begin, run1, acc);
+        accumulate(col, rows - run1, acc);
+        const std::int64_t t0 = timeAt(first);
+        const std::int64_t t1 = timeAt(last - 1);
+
+        if (!stillValid(first)) continue;
+        if (acc.n == 0) return false;
+
+        out.samples = acc.n;
+        out.min = acc.min;
+        out.max = acc.max;
+        out.mean = acc.sum / (double)acc.n;
+        out.rms = std::sqrt(acc.sumSq / (double)acc.n);
+        out.firstNanos = t0;
+        out.lastNanos = t1;
+        return true;
+    }
+    return false;
+}
+
+bool TimeSeriesStore::aggregateLast(std::size_t channel, std::int64_t windowNanos, Aggregate& out) const {
+    const std::int64_t newest = latestNanos();
+    if (newest == 0) return false;
+    return aggregate(channel, newest - windowNanos, std::numeric_limits<std::int64_t>::max(), out);
+}
+
+bool TimeSeriesStore::sampleAt(std::int64_t t, double* out, std::int64_t& beforeNanos, std::int64_t& afterNanos) const {
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+        const std::uint64_t head = head_.load(std::memory_order_acquire);
+        const std::uint64_t oldest = (head >= capacity_) ? head - capacity_ + 1 : 0;
+        if (head == oldest) return false;
+
+        // rows a <= t < b; b == head: hold the newest row
+        const std::uint64_t b = lowerBound(oldest, head, t + 1);
+        if (b == oldest) {
+            if (stillValid(oldest)) return false;
+            continue;
+        }
+        const std::uint64_t a = b - 1;
+        const std::size_t ra = (std::size_t)(a % capacity_);
+        const std::int64_t ta = times_[ra];
+
+        if (b == head) {
+            for (std::size_t c = 0; c < channels_; ++c) out[c] = values_[c * capacity_ + ra];
+            beforeNanos = afterNanos = ta;
+        } else {
+            const std::size_t rb = (std::size_t)(b % capacity_);
+            const std::int64_t tb = times_[rb];
+            const double w = (tb > ta) ? (double)(t - ta) / (double)(tb - ta) : 0.0;
+            for (std::size_t c = 0; c < channels_; ++c) {
+                const double va = values_[c * capacity_ + ra];
+                out[c] = va + (values_[c * capacity_ + rb] - va) * w;
+            }
+            beforeNanos = ta;
+            afterNanos = tb;
+        }
+        if (stillValid(a)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bounded in-memory history of a frame stream, one column per channel.
+//
+// Samples are kept in a ring of `capacity` rows: a timestamp column plus one
+// contiguous double column per channel (SoA), so a window of one channel is
+// at most two contiguous runs. Time lookups binary-search the timestamp
+// column, which must be non-decreasing (arrival times are).
+//
+// One writer (the receiver thread, see UdpDoubleReceiver::attachStore)
+// appends; any number of readers query concurrently without locks. Readers
+// validate after reading that the writer has not lapped the rows they used
+// and retry otherwise, seqlock style.
+//
+// Channels missing from a frame are stored as NaN; aggregates skip NaN.
+class TimeSeriesStore {
+public:
+    struct Aggregate {
+        std::size_t samples = 0;           // non-NaN samples in the window
+        double min = 0.0;
+        double max = 0.0;
+        double mean = 0.0;
+        double rms = 0.0;
+        std::int64_t firstNanos = 0;       // first / last row in the window
+        std::int64_t lastNanos = 0;
+    };
+
+    TimeSeriesStore(std::size_t channels, std::size_t capacity);
+
+    TimeSeriesStore(const TimeSeriesStore&) = delete;
+    TimeSeriesStore& operator=(const TimeSeriesStore&) = delete;
+
+    // Writer only. values[0..count) are channels 0..count-1.
+    void append(std::int64_t timeNanos, const double* values, std::size_t count);
+
+    std::size_t channels() const { return channels_; }
+    std::size_t capacity() const { return capacity_; }
+    std::size_t size() const;              // rows currently retained
+    std::int64_t latestNanos() const;      // 0 if empty
+
+    // Rows with fromNanos <= time <= toNanos. Returns the number copied.
+    std::size_t query(std::size_t channel, std::int64_t fromNanos, std::int64_t toNanos,
+                      std::vector<std::int64_t>& times, std::vector<double>& values) const;
+
+    // min / max / mean / RMS over fromNanos <= time <= toNanos.
+    // False if the channel is out of range or the window holds no samples.
+    bool aggregate(std::size_t channel, std::int64_t fromNanos, std::int64_t toNanos, Aggregate& out) const;
+
+    // Same, over the last windowNanos before the newest row.
+    bool aggregateLast(std::size_t channel, std::int64_t windowNanos, Aggregate& out) const;
+
+    // All channels at time t into out[0..channels()), linearly interpolated
+    // between the rows around t; after the newest row it is held. Sets the
+    // times of the rows used (equal when held). False if t is older than
+    // every retained row.
+    bool sampleAt(std::int64_t t, double* out, std::int64_t& beforeNanos, std::int64_t& afterNanos) const;
+
+private:
+    // First logical row with time >= t (or hi) in [lo, hi).
+    std::uint64_t lowerBound(std::uint64_t lo, std::uint64_t hi, std::int64_t t) const;
+    // Logical row range [first, last) for a time window, from a head snapshot.
+    void window(std::uint64_t head, std::int64_t fromNanos, std::int64_t toNanos,
+                std::uint64_t& first, std::uint64_t& last) const;
+    // True if rows >= first were not overwritten while they were read.
+    bool stillValid(std::uint64_t first) const;
+
+    std::int64_t timeAt(std::uint64_t row) const { return times_[row % capacity_]; }
+
+private:
+    const std::size_t channels_;
+    const std::size_t capacity_;
+    std::vector<std::int64_t> times_;
+    std::vector<double> values_;           // channel c at [c * capacity_, (c + 1) * capacity_)
+
+    std::atomic<std::uint64_t> head_{0};    // rows published
+    std::atomic<std::uint64_t> writing_{0}; // row being written + 1
+};
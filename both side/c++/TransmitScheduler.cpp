@@ -0,0 +1,297 @@
+#include "TransmitScheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+
+static constexpr std::int64_t IDLE_WAKE_NANOS = 100 * 1000 * 1000; // re-check at least every 100 ms
+
+TransmitScheduler::TransmitScheduler(std::size_t maxDoubles, std::uint32_t poolFrames)
+    : maxDoubles_(maxDoubles),
+      pool_(maxDoubles, poolFrames)
+{
+}
+
+TransmitScheduler::~TransmitScheduler() {
+    stop();
+}
+
+// ---------- configuration ----------
+int TransmitScheduler::addStream(UdpDoubleSender& sender, Priority prio, double weight, std::size_t queueDepth) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::unique_ptr<Stream> s(new Stream());
+    s->sender = &sender;
+    s->prio = prio;
+    s->weight = (weight > 0.0) ? weight : 1.0;
+    s->ring.resize(std::max<std::size_t>(1, queueDepth));
+    streams_.push_back(std::move(s));
+    buckets_.emplace(&sender, Bucket());
+    return (int)streams_.size() - 1;
+}
+
+int TransmitScheduler::addPeriodicStream(UdpDoubleSender& sender, Priority prio, double weight,
+                                         std::int64_t periodNanos, Producer producer, std::size_t queueDepth) {
+    if (periodNanos <= 0 || !producer) throw std::invalid_argument("periodic stream needs period and producer");
+    const int id = addStream(sender, prio, weight, queueDepth);
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    Stream& s = *streams_[(std::size_t)id];
+    s.period = periodNanos;
+    s.producer = std::move(producer);
+    restaggerLocked(s);
+    cv_.notify_one();
+    return id;
+}
+
+void TransmitScheduler::restaggerLocked(Stream& added) {
+    const std::int64_t period = added.period;
+    std::vector<Stream*> same;
+    for (auto& s : streams_)
+        if (s->period == period && s.get() != &added) same.push_back(s.get());
+
+    if (!running_) {
+        // spread streams sharing a period evenly across it; start() derives
+        // nextDue from the offsets
+        same.push_back(&added);
+        for (std::size_t k = 0; k < same.size(); ++k) {
+            same[k]->phaseOffset = (std::int64_t)((double)period * (double)k / (double)same.size());
+            same[k]->nextDue = epoch_ + same[k]->phaseOffset;
+        }
+        return;
+    }
+
+    // running: the others keep their phase; the new stream takes the middle
+    // of the widest gap between them
+    std::int64_t offset = 0;
+    if (!same.empty()) {
+        std::vector<std::int64_t> phases;
+        for (Stream* s : same) phases.push_back(s->phaseOffset);
+        std::sort(phases.begin(), phases.end());
+        std::int64_t widest = phases.front() + period - phases.back();   // wraps around
+        offset = phases.back() + widest / 2;
+        for (std::size_t k = 1; k < phases.size(); ++k) {
+            const std::int64_t gap = phases[k] - phases[k - 1];
+            if (gap > widest) {
+                widest = gap;
+                offset = phases[k - 1] + gap / 2;
+            }
+        }
+        offset %= period;
+    }
+    added.phaseOffset = offset;
+
+    const std::int64_t now = nowNanos();
+    std::int64_t due = epoch_ + offset;
+    if (due < now) due += ((now - due) / period + 1) * period;
+    added.nextDue = due;
+}
+
+void TransmitScheduler::setDestinationRate(UdpDoubleSender& sender, double bytesPerSecond, double burstBytes) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Bucket& b = buckets_[&sender];
+    b.rate = bytesPerSecond;
+    b.burst = std::max(burstBytes, (double)frameBytes(maxDoubles_));
+    b.tokens = b.burst;
+    b.lastRefill = nowNanos();
+}
+
+// ---------- submit ----------
+bool TransmitScheduler::submit(int streamId, const double* data, int count) {
+    if (!data || count <= 0 || (std::size_t)count > maxDoubles_) return false;
+
+    FramePool::Frame f = pool_.acquire();   // lock-free, outside mtx_
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (streamId < 0 || (std::size_t)streamId >= streams_.size()) return false;
+    Stream& s = *streams_[(std::size_t)streamId];
+    if (!f) {
+        ++s.stats.dropped;
+        return false;
+    }
+
+    std::copy(data, data + count, f.data());
+    f.header().count = (std::uint16_t)count;
+    if (!enqueueLocked(s, std::move(f), nowNanos())) return false;
+    cv_.notify_one();
+    return true;
+}
+
+bool TransmitScheduler::enqueueLocked(Stream& s, FramePool::Frame&& frame, std::int64_t now) {
+    if (s.size == s.ring.size()) {
+        ++s.stats.dropped;
+        return false;
+    }
+    Entry& e = s.ring[(s.head + s.size) % s.ring.size()];
+    const double bytes = (double)frameBytes(frame.header().count);
+    e.frame = std::move(frame);
+    e.enqueuedNanos = now;
+    e.finishTag = std::max(virtualTime_, s.lastFinish) + bytes / s.weight;
+    s.lastFinish = e.finishTag;
+    ++s.size;
+    return true;
+}
+
+// ---------- dispatch ----------
+bool TransmitScheduler::start() {
+    if (running_) return true;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        epoch_ = nowNanos();
+        for (auto& s : streams_)
+            if (s->period > 0) s->nextDue = epoch_ + s->phaseOffset;
+    }
+    running_ = true;
+    thread_ = std::thread(&TransmitScheduler::run, this);
+    return true;
+}
+
+void TransmitScheduler::stop() {
+    if (!running_) return;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void TransmitScheduler::refillLocked(Bucket& b, std::int64_t now) {
+    if (b.rate <= 0.0) return;
+    const double dt = (double)(now - b.lastRefill) * 1e-9;
+    b.tokens = std::min(b.burst, b.tokens + dt * b.rate);
+    b.lastRefill = now;
+}
+
+int TransmitScheduler::selectLocked(std::int64_t now, std::int64_t& wakeAt) {
+    int urgent = -1;
+    int weighted = -1;
+    std::int64_t oldestUrgent = std::numeric_limits<std::int64_t>::max();
+    double bestFinish = std::numeric_limits<double>::infinity();
+
+    for (auto& b : buckets_) refillLocked(b.second, now);
+
+    for (std::size_t i = 0; i < streams_.size(); ++i) {
+        Stream& s = *streams_[i];
+        if (s.size == 0) continue;
+        const Entry& head = s.ring[s.head];
+
+        if (s.prio == Priority::Urgent) {
+            if (head.enqueuedNanos < oldestUrgent) {
+                oldestUrgent = head.enqueuedNanos;
+                urgent = (int)i;
+            }
+            continue;
+        }
+
+        const Bucket& b = buckets_[s.sender];
+        const double bytes = (double)frameBytes(head.frame.header().count);
+        if (b.rate > 0.0 && b.tokens < bytes) {
+            const std::int64_t ready = now + (std::int64_t)((bytes - b.tokens) / b.rate * 1e9) + 1;
+            wakeAt = std::min(wakeAt, ready);
+            continue;
+        }
+        if (head.finishTag < bestFinish) {
+            bestFinish = head.finishTag;
+            weighted = (int)i;
+        }
+    }
+    return (urgent >= 0) ? urgent : weighted;
+}
+
+void TransmitScheduler::producePeriodic(std::unique_lock<std::mutex>& lk, std::int64_t now, std::int64_t& wakeAt) {
+    for (std::size_t i = 0; i < streams_.size(); ++i) {
+        Stream* s = streams_[i].get();
+        if (s->period <= 0) continue;
+        if (s->nextDue > now) {
+            wakeAt = std::min(wakeAt, s->nextDue);
+            continue;
+        }
+
+        // keep the phase; skip cycles we are too late for
+        const std::int64_t behind = (now - s->nextDue) / s->period;
+        s->nextDue += (behind + 1) * s->period;
+        wakeAt = std::min(wakeAt, s->nextDue);
+
+        FramePool::Frame f = pool_.acquire();
+        if (!f) { ++s->stats.dropped; continue; }
+
+        Producer producer = s->producer;
+        lk.unlock();
+        const int n = producer(f.data(), (int)maxDoubles_);
+        lk.lock();
+
+        if (n <= 0 || (std::size_t)n > maxDoubles_) continue;
+        f.header().count = (std::uint16_t)n;
+        enqueueLocked(*s, std::move(f), nowNanos());
+    }
+}
+
+void TransmitScheduler::run() {
+    std::unique_lock<std::mutex> lk(mtx_);
+    while (running_) {
+        const std::int64_t now = nowNanos();
+        std::int64_t wakeAt = now + IDLE_WAKE_NANOS;
+
+        producePeriodic(lk, now, wakeAt);
+
+        const int pick = selectLocked(nowNanos(), wakeAt);
+        if (pick < 0) {
+            cv_.wait_for(lk, std::chrono::nanoseconds(std::max<std::int64_t>(0, wakeAt - nowNanos())));
+            continue;
+        }
+
+        Stream& s = *streams_[(std::size_t)pick];
+        Entry& e = s.ring[s.head];
+        FramePool::Frame frame = std::move(e.frame);
+        const std::int64_t enqueued = e.enqueuedNanos;
+        s.head = (s.head + 1) % s.ring.size();
+        --s.size;
+
+        const std::size_t count = frame.header().count;
+        Bucket& b = buckets_[s.sender];
+        if (b.rate > 0.0) b.tokens -= (double)frameBytes(count);   // urgent may go negative
+        if (s.prio == Priority::Weighted) virtualTime_ = std::max(virtualTime_, e.finishTag);
+
+        UdpDoubleSender* sender = s.sender;
+        lk.unlock();
+        bool ok = true;
+        try {
+            sender->sendAutoSeq(frame.data(), (int)count);
+        } catch (const std::exception&) {
+            ok = false;
+        }
+        const std::int64_t queued = nowNanos() - enqueued;
+        frame.reset();
+        lk.lock();
+
+        if (!ok) { ++s.stats.sendErrors; continue; }
+        ++s.stats.sent;
+        s.queueNanosSum += (double)queued;
+        s.stats.meanQueueNanos = s.queueNanosSum / (double)s.stats.sent;
+        s.stats.maxQueueNanos = std::max(s.stats.maxQueueNanos, queued);
+    }
+}
+
+// ---------- stats ----------
+TransmitScheduler::Stats TransmitScheduler::streamStats(int streamId) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (streamId < 0 || (std::size_t)streamId >= streams_.size()) return Stats();
+    return streams_[(std::size_t)streamId]->stats;
+}
+
+TransmitScheduler::Stats TransmitScheduler::classStats(Priority prio) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Stats out;
+    double sum = 0.0;
+    for (const auto& s : streams_) {
+        if (s->prio != prio) continue;
+        out.sent += s->stats.sent;
+        out.dropped += s->stats.dropped;
+        out.sendErrors += s->stats.sendErrors;
+        out.maxQueueNanos = std::max(out.maxQueueNanos, s->stats.maxQueueNanos);
+        sum += s->queueNanosSum;
+    }
+    out.meanQueueNanos = out.sent ? sum / (double)out.sent : 0.0;
+    return out;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FramePool.hpp"
+#include "UdpDoubleSender.hpp"
+#include "SteadyClock.hpp"
+
+// Transmit scheduler for many streams leaving one PC.
+//
+// - Urgent streams (stops, overrides) are served first, in FIFO order.
+// - Weighted streams share what is left by self-clocked fair queueing.
+// - A token bucket per destination (sender) caps bytes/s and burst so a
+//   receiver's flood limit is respected; urgent frames may overdraw it.
+// - Periodic streams are produced by a callback at their own phase; streams
+//   with the same period are staggered evenly across it. One added while
+//   running goes into the widest gap and leaves the others' phases alone.
+//
+// Frames are copied into a FramePool on submit; one dispatcher thread sends.
+class TransmitScheduler {
+public:
+    enum class Priority { Urgent, Weighted };
+
+    struct Stats {
+        std::uint64_t sent = 0;
+        std::uint64_t dropped = 0;         // queue full / pool exhausted
+        std::uint64_t sendErrors = 0;
+        double meanQueueNanos = 0.0;       // submit -> handed to the socket
+        std::int64_t maxQueueNanos = 0;
+    };
+
+    // Fills out[0..maxCount) and returns the count (<= 0: nothing to send).
+    using Producer = std::function<int(double* out, int maxCount)>;
+
+    // maxDoubles: largest frame any stream sends; poolFrames: total queued frames
+    explicit TransmitScheduler(std::size_t maxDoubles = 172, std::uint32_t poolFrames = 1024);
+    ~TransmitScheduler();
+
+    TransmitScheduler(const TransmitScheduler&) = delete;
+    TransmitScheduler& operator=(const TransmitScheduler&) = delete;
+
+    // Senders must outlive the scheduler. Returns the stream id.
+    int addStream(UdpDoubleSender& sender, Priority prio, double weight = 1.0, std::size_t queueDepth = 64);
+    int addPeriodicStream(UdpDoubleSender& sender, Priority prio, double weight,
+                          std::int64_t periodNanos, Producer producer, std::size_t queueDepth = 4);
+
+    // bytesPerSecond <= 0: unlimited
+    void setDestinationRate(UdpDoubleSender& sender, double bytesPerSecond, double burstBytes);
+
+    // Copies the frame into the stream's queue. False if it was dropped.
+    bool submit(int streamId, const double* data, int count);
+
+    bool start();
+    void stop();
+    bool isRunning() const { return running_.load(); }
+
+    Stats streamStats(int streamId) const;
+    Stats classStats(Priority prio) const;
+
+private:
+    struct Entry {
+        FramePool::Frame frame;
+        std::int64_t enqueuedNanos = 0;
+        double finishTag = 0.0;            // WFQ virtual finish time
+    };
+
+    struct Bucket {
+        double rate = 0.0;                 // bytes/s, <= 0 unlimited
+        double burst = 0.0;
+        double tokens = 0.0;
+        std::int64_t lastRefill = 0;
+    };
+
+    struct Stream {
+        UdpDoubleSender* sender = nullptr;
+        Priority prio = Priority::Weighted;
+        double weight = 1.0;
+        std::vector<Entry> ring;
+        std::size_t head = 0;
+        std::size_t size = 0;
+        double lastFinish = 0.0;
+
+        // periodic streams
+        std::int64_t period = 0;
+        std::int64_t phaseOffset = 0;
+        std::int64_t nextDue = 0;
+        Producer producer;
+
+        Stats stats;
+        double queueNanosSum = 0.0;
+    };
+
+    void run();
+    bool enqueueLocked(Stream& s, FramePool::Frame&& frame, std::int64_t now);
+    int  selectLocked(std::int64_t now, std::int64_t& wakeAt);
+    void refillLocked(Bucket& b, std::int64_t now);
+    // Phases a new periodic stream against the others with its period.
+    void restaggerLocked(Stream& added);
+    void producePeriodic(std::unique_lock<std::mutex>& lk, std::int64_t now, std::int64_t& wakeAt);
+
+    static std::size_t frameBytes(std::size_t count) { return UdpDoubleSender::HEADER_BYTES + count * 8; }
+    static std::int64_t nowNanos() { return SteadyClock::nowNanos(); }
+
+private:
+    const std::size_t maxDoubles_;
+    FramePool pool_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::vector<std::unique_ptr<Stream>> streams_;
+    std::map<UdpDoubleSender*, Bucket> buckets_;
+    double virtualTime_ = 0.0;
+    std::int64_t epoch_ = 0;
+
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
@@ -0,0 +1,163 @@
+#include "TriggerEngine.hpp"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "Simd.hpp"
+
+static constexpr std::uint64_t ALL_ONES = ~std::uint64_t(0);
+
+TriggerEngine::TriggerEngine(Callback callback, std::size_t queueCapacity)
+    : callback_(std::move(callback))
+{
+    if (queueCapacity > 0) queue_.reset(new MpmcQueue<Event>(queueCapacity));
+}
+
+int TriggerEngine::addRule(const Rule& rule) {
+    if (rule.hysteresis < 0.0) throw std::invalid_argument("TriggerEngine hysteresis must be >= 0");
+    if ((rule.kind == Kind::Change || rule.kind == Kind::Rate) && rule.threshold < 0.0)
+        throw std::invalid_argument("TriggerEngine Change/Rate threshold must be >= 0");
+
+    double sign = 1.0, limit = rule.threshold, rearm = rule.threshold - rule.hysteresis;
+    std::uint64_t diff = 0, rate = 0, level = 0;
+    switch (rule.kind) {
+    case Kind::Above:
+        break;
+    case Kind::Below:
+        sign = -1.0;
+        limit = -rule.threshold;
+        rearm = -(rule.threshold + rule.hysteresis);
+        break;
+    case Kind::Change:
+        diff = ALL_ONES;
+        level = ALL_ONES;
+        break;
+    case Kind::Rate:
+        diff = ALL_ONES;
+        rate = ALL_ONES;
+        if (rearm < 0.0) rearm = 0.0;
+        break;
+    }
+
+    // keep the arrays even: the padding lane is a Change rule on NaN
+    if (rules_.size() % 2 == 0) {
+        sign_.resize(sign_.size() + 2, 1.0);
+        diffMask_.resize(diffMask_.size() + 2, ALL_ONES);
+        rateMask_.resize(rateMask_.size() + 2, 0);
+        levelMask_.resize(levelMask_.size() + 2, ALL_ONES);
+        limit_.resize(limit_.size() + 2, 0.0);
+        rearm_.resize(rearm_.size() + 2, 0.0);
+        armed_.resize(armed_.size() + 2, ALL_ONES);
+        current_.resize(current_.size() + 2, std::numeric_limits<double>::quiet_NaN());
+        previous_.resize(previous_.size() + 2, std::numeric_limits<double>::quiet_NaN());
+    }
+    const std::size_t r = rules_.size();
+    sign_[r] = sign;
+    diffMask_[r] = diff;
+    rateMask_[r] = rate;
+    levelMask_[r] = level;
+    limit_[r] = limit;
+    rearm_[r] = rearm;
+    armed_[r] = ALL_ONES;
+    rules_.push_back(rule);
+    primed_ = false;
+    return (int)r;
+}
+
+void TriggerEngine::evaluate(std::uint32_t seq, std::uint64_t timestampNanos, std::int64_t arrivalNanos,
+                             const double* values, std::size_t count) {
+    frames_.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t n = rules_.size();
+    if (n == 0) return;
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (std::size_t r = 0; r < n; ++r) {
+        const std::size_t ch = rules_[r].channel;
+        current_[r] = (ch < count) ? values[ch] : nan;
+    }
+
+    if (!primed_) {
+        // no previous frame: limits start armed unless already beyond
+        for (std::size_t r = 0; r < n; ++r)
+            armed_[r] = (diffMask_[r] || !(sign_[r] * current_[r] > limit_[r])) ? ALL_ONES : 0;
+        primed_ = true;
+        lastTimestamp_ = timestampNanos;
+        current_.swap(previous_);
+        return;
+    }
+
+    // Rate needs increasing sender timestamps; otherwise its limit is +inf
+    double dt = std::numeric_limits<double>::infinity();
+    if (timestampNanos > lastTimestamp_) dt = double(timestampNanos - lastTimestamp_) * 1e-9;
+    lastTimestamp_ = timestampNanos;
+
+    const std::size_t padded = current_.size();
+#if SIMD_SSE2
+    const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d vdt = _mm_set1_pd(dt);
+    for (std::size_t r = 0; r < padded; r += 2) {
+        const __m128d cur = _mm_loadu_pd(&current_[r]);
+        const __m128d prev = _mm_loadu_pd(&previous_[r]);
+        const __m128d diffSel = _mm_castsi128_pd(_mm_loadu_si128((const __m128i*)&diffMask_[r]));
+        const __m128d rateSel = _mm_castsi128_pd(_mm_loadu_si128((const __m128i*)&rateMask_[r]));
+        const __m128d levelSel = _mm_castsi128_pd(_mm_loadu_si128((const __m128i*)&levelMask_[r]));
+        const __m128d armed = _mm_castsi128_pd(_mm_loadu_si128((const __m128i*)&armed_[r]));
+
+        const __m128d diff = _mm_and_pd(_mm_sub_pd(cur, prev), absMask);
+        const __m128d lvl = _mm_mul_pd(_mm_loadu_pd(&sign_[r]), cur);
+        const __m128d x = _mm_or_pd(_mm_and_pd(diffSel, diff), _mm_andnot_pd(diffSel, lvl));
+        const __m128d scale = _mm_or_pd(_mm_and_pd(rateSel, vdt), _mm_andnot_pd(rateSel, one));
+
+        const __m128d fired = _mm_and_pd(armed, _mm_cmpgt_pd(x, _mm_mul_pd(_mm_loadu_pd(&limit_[r]), scale)));
+        const __m128d rearm = _mm_cmple_pd(x, _mm_mul_pd(_mm_loadu_pd(&rearm_[r]), scale));
+        const __m128d next = _mm_or_pd(_mm_or_pd(_mm_andnot_pd(fired, armed), rearm), levelSel);
+        _mm_storeu_si128((__m128i*)&armed_[r], _mm_castpd_si128(next));
+
+        if (const int bits = _mm_movemask_pd(fired)) {
+            if ((bits & 1) && r < n) fire(r, seq, timestampNanos, arrivalNanos);
+            if ((bits & 2) && r + 1 < n) fire(r + 1, seq, timestampNanos, arrivalNanos);
+        }
+    }
+#else
+    for (std::size_t r = 0; r < padded; ++r) {
+        const double x = diffMask_[r] ? std::fabs(current_[r] - previous_[r]) : sign_[r] * current_[r];
+        const double scale = rateMask_[r] ? dt : 1.0;
+        const bool hit = armed_[r] && x > limit_[r] * scale;
+        const bool rearm = x <= rearm_[r] * scale;
+        armed_[r] = ((armed_[r] && !hit) || rearm || levelMask_[r]) ? ALL_ONES : 0;
+        if (hit && r < n) fire(r, seq, timestampNanos, arrivalNanos);
+    }
+#endif
+    current_.swap(previous_);
+}
+
+void TriggerEngine::fire(std::size_t r, std::uint32_t seq, std::uint64_t timestampNanos, std::int64_t arrivalNanos) {
+    const Rule& rule = rules_[r];
+    Event e;
+    e.rule = (int)r;
+    e.kind = rule.kind;
+    e.channel = rule.channel;
+    e.seq = seq;
+    e.timestampNanos = timestampNanos;
+    e.arrivalNanos = arrivalNanos;
+    e.previous = previous_[r];
+    e.value = current_[r];
+    fired_.fetch_add(1, std::memory_order_relaxed);
+
+    if (callback_) callback_(e);
+    if (queue_ && !queue_->tryPush(std::move(e))) queueDropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool TriggerEngine::poll(Event& out) {
+    return queue_ && queue_->tryPop(out);
+}
+
+TriggerEngine::Stats TriggerEngine::stats() const {
+    Stats s;
+    s.frames = frames_.load(std::memory_order_relaxed);
+    s.fired = fired_.load(std::memory_order_relaxed);
+    s.queueDropped = queueDropped_.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "MpmcQueue.hpp"
+
+// Per-channel trigger rules evaluated on every frame of a stream.
+//
+// Attached with UdpDoubleReceiver::attachTriggers, the engine sees each
+// frame on the receiver thread as it is published, so an excursion that
+// lasts a single frame is caught even if nobody polls in between. Each
+// rule compares the frame against the previous one:
+//
+//   Above   value rises above threshold (re-armed below threshold - hysteresis)
+//   Below   value falls below threshold (re-armed above threshold + hysteresis)
+//   Change  |value - previous| > threshold (0: any change), every frame it happens
+//   Rate    |value - previous| / dt > threshold per second, dt from the sender
+//           timestamps (re-armed below threshold - hysteresis)
+//
+// The rules are kept as arrays and evaluated two at a time with SSE2
+// (scalar elsewhere); only firing rules leave the vector loop. A fired
+// Event carries the frame's seq, sender timestamp and arrival time and is
+// passed to the callback (receiver thread, keep it short) and/or queued
+// for other threads (poll). The first frame only sets the state. Channels
+// missing from a frame (or NaN) never fire.
+//
+// Rules are added before attaching; evaluate() and reset() belong to the
+// receiver thread, poll() and stats() to any thread.
+class TriggerEngine {
+public:
+    enum class Kind : std::uint8_t {
+        Above,
+        Below,
+        Change,
+        Rate,
+    };
+
+    struct Rule {
+        Kind kind = Kind::Above;
+        std::uint16_t channel = 0;
+        double threshold = 0.0;
+        double hysteresis = 0.0;   // Above, Below, Rate
+    };
+
+    struct Event {
+        int rule = -1;                        // addRule() id
+        Kind kind = Kind::Above;
+        std::uint16_t channel = 0;
+        std::uint32_t seq = 0;
+        std::uint64_t timestampNanos = 0;     // sender
+        std::int64_t  arrivalNanos = 0;
+        double previous = 0.0;
+        double value = 0.0;
+    };
+    using Callback = std::function<void(const Event&)>;
+
+    struct Stats {
+        std::uint64_t frames = 0;
+        std::uint64_t fired = 0;
+        std::uint64_t queueDropped = 0;       // queue full, event lost (callback still ran)
+    };
+
+    // queueCapacity 0: callback only.
+    explicit TriggerEngine(Callback callback = nullptr, std::size_t queueCapacity = 1024);
+
+    TriggerEngine(const TriggerEngine&) = delete;
+    TriggerEngine& operator=(const TriggerEngine&) = delete;
+
+    // Returns the rule id. Throws std::invalid_argument for a negative
+    // threshold of Change/Rate or a negative hysteresis.
+    int addRule(const Rule& rule);
+    int ruleCount() const { return (int)rules_.size(); }
+    const Rule& rule(int id) const { return rules_.at((std::size_t)id); }
+
+    // Receiver thread: one frame of the stream.
+    void evaluate(std::uint32_t seq, std::uint64_t timestampNanos, std::int64_t arrivalNanos,
+                  const double* values, std::size_t count);
+    // Forget the previous frame (the next one only sets the state).
+    void reset() { primed_ = false; }
+
+    // Oldest queued event; false if none.
+    bool poll(Event& out);
+
+    Stats stats() const;
+
+private:
+    void fire(std::size_t r, std::uint32_t seq, std::uint64_t timestampNanos, std::int64_t arrivalNanos);
+
+private:
+    const Callback callback_;
+    std::unique_ptr<MpmcQueue<Event>> queue_;
+
+    std::vector<Rule> rules_;
+
+    // One entry per rule, padded to even length for the SSE2 loop. Every
+    // rule tests x > limit * scale with x = sign * value (Above, Below) or
+    // |value - previous| (Change, Rate); scale is dt for Rate, else 1.
+    // Masks are all-ones / zero 64-bit patterns.
+    std::vector<double> sign_;
+    std::vector<std::uint64_t> diffMask_;     // x from the difference
+    std::vector<std::uint64_t> rateMask_;     // limit scaled by dt
+    std::vector<std::uint64_t> levelMask_;    // never disarms (Change)
+    std::vector<double> limit_;
+    std::vector<double> rearm_;               // armed again once x <= rearm * scale
+    std::vector<std::uint64_t> armed_;
+    std::vector<double> current_;
+    std::vector<double> previous_;
+
+    bool primed_ = false;
+    std::uint64_t lastTimestamp_ = 0;
+
+    std::atomic<std::uint64_t> frames_{0};
+    std::atomic<std::uint64_t> fired_{0};
+    std::atomic<std::uint64_t> queueDropped_{0};
+};
@@ -0,0 +1,244 @@
+#include "UdpAuth.hpp"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+  #include <immintrin.h>
+  #define UDPAUTH_AVX2 1
+#endif
+
+#include "Simd.hpp"
+
+namespace {
+
+constexpr std::size_t NH_BLOCK = 16;            // bytes per two word pairs
+constexpr std::size_t NH_SHIFT = 4;             // Toeplitz key offset (words) of the second pass
+
+std::uint64_t load64le(const std::uint8_t* p) {
+    std::uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+void store64le(std::uint8_t* p, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = std::uint8_t(v >> (8 * i));
+}
+
+std::uint32_t load32le(const std::uint8_t* p) {
+    return std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) | (std::uint32_t(p[2]) << 16) | (std::uint32_t(p[3]) << 24);
+}
+
+inline std::uint64_t rotl(std::uint64_t x, int b) { return (x << b) | (x >> (64 - b)); }
+
+inline void sipRound(std::uint64_t& v0, std::uint64_t& v1, std::uint64_t& v2, std::uint64_t& v3) {
+    v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+    v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+    v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+    v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+}
+
+// NH over one 16-byte block for both key offsets.
+inline void nhBlockScalar(const std::uint8_t* p, const std::uint32_t* k, std::uint64_t& a, std::uint64_t& b) {
+    const std::uint32_t m0 = load32le(p), m1 = load32le(p + 4), m2 = load32le(p + 8), m3 = load32le(p + 12);
+    a += std::uint64_t(std::uint32_t(m0 + k[0])) * std::uint32_t(m1 + k[1]) +
+         std::uint64_t(std::uint32_t(m2 + k[2])) * std::uint32_t(m3 + k[3]);
+    const std::uint32_t* s = k + NH_SHIFT;
+    b += std::uint64_t(std::uint32_t(m0 + s[0])) * std::uint32_t(m1 + s[1]) +
+         std::uint64_t(std::uint32_t(m2 + s[2])) * std::uint32_t(m3 + s[3]);
+}
+
+} // namespace
+
+// ---------- SipHash-2-4 ----------
+std::uint64_t UdpAuth::sipHash24(std::uint64_t k0, std::uint64_t k1, const std::uint8_t* p, std::size_t n) {
+    std::uint64_t v0 = 0x736f6d6570736575ull ^ k0;
+    std::uint64_t v1 = 0x646f72616e646f6dull ^ k1;
+    std::uint64_t v2 = 0x6c7967656e657261ull ^ k0;
+    std::uint64_t v3 = 0x7465646279746573ull ^ k1;
+
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const std::uint64_t m = load64le(p + i);
+        v3 ^= m;
+        sipRound(v0, v1, v2, v3);
+        sipRound(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+    std::uint64_t last = std::uint64_t(n) << 56;
+    for (std::size_t j = 0; i + j < n; ++j) last |= std::uint64_t(p[i + j]) << (8 * j);
+    v3 ^= last;
+    sipRound(v0, v1, v2, v3);
+    sipRound(v0, v1, v2, v3);
+    v0 ^= last;
+
+    v2 ^= 0xff;
+    for (int r = 0; r < 4; ++r) sipRound(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// ---------- keys ----------
+UdpAuth::UdpAuth(const std::uint8_t key[KEY_BYTES]) {
+    const std::uint64_t m0 = load64le(key);
+    const std::uint64_t m1 = load64le(key + 8);
+
+    // counter-mode derivation: SipHash(master, domain || index)
+    auto derive = [&](std::uint64_t domain, std::uint64_t index) {
+        std::uint8_t in[16];
+        store64le(in, domain);
+        store64le(in + 8, index);
+        return sipHash24(m0, m1, in, sizeof(in));
+    };
+    k0_ = derive(0, 0);
+    k1_ = derive(0, 1);
+
+    nhKey_.resize(MAX_BYTES / 4 + NH_SHIFT);
+    for (std::size_t i = 0; i < nhKey_.size(); i += 2) {
+        const std::uint64_t w = derive(1, i / 2);
+        nhKey_[i] = std::uint32_t(w);
+        if (i + 1 < nhKey_.size()) nhKey_[i + 1] = std::uint32_t(w >> 32);
+    }
+}
+
+// ---------- NH ----------
+std::uint64_t UdpAuth::nh(const std::uint8_t* p, std::size_t n, std::uint64_t& second) const {
+    const std::uint32_t* k = nhKey_.data();
+    std::uint64_t a = 0, b = 0;
+    std::size_t i = 0;
+
+#if UDPAUTH_AVX2
+    // 32 bytes per step; lanes pair words (0,1) (2,3) (4,5) (6,7)
+    __m256i accA = _mm256_setzero_si256(), accB = _mm256_setzero_si256();
+    for (; i + 2 * NH_BLOCK <= n; i += 2 * NH_BLOCK, k += 8) {
+        const __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        const __m256i sa = _mm256_add_epi32(m, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(k)));
+        const __m256i sb = _mm256_add_epi32(m, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(k + NH_SHIFT)));
+        accA = _mm256_add_epi64(accA, _mm256_mul_epu32(sa, _mm256_srli_epi64(sa, 32)));
+        accB = _mm256_add_epi64(accB, _mm256_mul_epu32(sb, _mm256_srli_epi64(sb, 32)));
+    }
+    std::uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), accA);
+    a = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), accB);
+    b = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i + NH_BLOCK <= n; i += NH_BLOCK, k += 4) nhBlockScalar(p + i, k, a, b);
+#elif SIMD_SSE2
+    // two blocks per step into separate accumulators: the adds of one
+    // block do not wait for the multiplies of the other
+    __m128i accA0 = _mm_setzero_si128(), accA1 = _mm_setzero_si128();
+    __m128i accB0 = _mm_setzero_si128(), accB1 = _mm_setzero_si128();
+    for (; i + 2 * NH_BLOCK <= n; i += 2 * NH_BLOCK, k += 8) {
+        const __m128i m0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        const __m128i m1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + NH_BLOCK));
+        const __m128i k0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(k));
+        const __m128i k1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(k + 4));   // == k0 shifted by NH_SHIFT
+        const __m128i k2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(k + 8));
+        const __m128i sa0 = _mm_add_epi32(m0, k0), sb0 = _mm_add_epi32(m0, k1);
+        const __m128i sa1 = _mm_add_epi32(m1, k1), sb1 = _mm_add_epi32(m1, k2);
+        // low word times high word of each 64-bit half
+        accA0 = _mm_add_epi64(accA0, _mm_mul_epu32(sa0, _mm_srli_epi64(sa0, 32)));
+        accB0 = _mm_add_epi64(accB0, _mm_mul_epu32(sb0, _mm_srli_epi64(sb0, 32)));
+        accA1 = _mm_add_epi64(accA1, _mm_mul_epu32(sa1, _mm_srli_epi64(sa1, 32)));
+        accB1 = _mm_add_epi64(accB1, _mm_mul_epu32(sb1, _mm_srli_epi64(sb1, 32)));
+    }
+    std::uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), _mm_add_epi64(accA0, accA1));
+    a = lanes[0] + lanes[1];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), _mm_add_epi64(accB0, accB1));
+    b = lanes[0] + lanes[1];
+    for (; i + NH_BLOCK <= n; i += NH_BLOCK, k += 4) nhBlockScalar(p + i, k, a, b);
+#else
+    for (; i + NH_BLOCK <= n; i += NH_BLOCK, k += 4) nhBlockScalar(p + i, k, a, b);
+#endif
+
+    if (i < n) {
+        // zero-padded last block; the length goes into the final tag
+        std::uint8_t tail[NH_BLOCK] = {0};
+        std::memcpy(tail, p + i, n - i);
+        nhBlockScalar(tail, k, a, b);
+    }
+    second = b;
+    return a;
+}
+
+std::uint64_t UdpAuth::nhScalar(const std::uint8_t* p, std::size_t n, std::uint64_t& second) const {
+    const std::uint32_t* k = nhKey_.data();
+    std::uint64_t a = 0, b = 0;
+    std::size_t i = 0;
+    for (; i + NH_BLOCK <= n; i += NH_BLOCK, k += 4) nhBlockScalar(p + i, k, a, b);
+    if (i < n) {
+        std::uint8_t tail[NH_BLOCK] = {0};
+        std::memcpy(tail, p + i, n - i);
+        nhBlockScalar(tail, k, a, b);
+    }
+    second = b;
+    return a;
+}
+
+std::uint64_t UdpAuth::tag(const std::uint8_t* p, std::size_t n) const {
+    if (n > MAX_BYTES) n = MAX_BYTES;   // callers never send more; keeps nh() in its key
+    std::uint64_t b = 0;
+    const std::uint64_t a = nh(p, n, b);
+    return finish(a, b, n);
+}
+
+std::uint64_t UdpAuth::tagScalar(const std::uint8_t* p, std::size_t n) const {
+    if (n > MAX_BYTES) n = MAX_BYTES;
+    std::uint64_t b = 0;
+    const std::uint64_t a = nhScalar(p, n, b);
+    return finish(a, b, n);
+}
+
+std::uint64_t UdpAuth::finish(std::uint64_t a, std::uint64_t b, std::size_t n) const {
+    std::uint8_t in[24];
+    store64le(in, a);
+    store64le(in + 8, b);
+    store64le(in + 16, n);
+    return sipHash24(k0_, k1_, in, sizeof(in));
+}
+
+void UdpAuth::sign(std::uint8_t* p, std::size_t n) const {
+    const std::uint64_t t = tag(p, n);
+    for (int i = 0; i < 8; ++i) p[n + i] = std::uint8_t(t >> (56 - 8 * i));
+}
+
+bool UdpAuth::verify(const std::uint8_t* p, std::size_t n) const {
+    if (n < TAG_BYTES || n > MAX_BYTES) return false;
+    const std::size_t body = n - TAG_BYTES;
+    const std::uint64_t t = tag(p, body);
+    // constant time: no early exit on the first differing byte
+    std::uint8_t diff = 0;
+    for (int i = 0; i < 8; ++i) diff |= std::uint8_t(p[body + i] ^ std::uint8_t(t >> (56 - 8 * i)));
+    return diff == 0;
+}
+
+// ---------- replay window ----------
+bool UdpAuth::ReplayWindow::accept(std::uint32_t seq, std::uint64_t timestampNanos) {
+    // older than the (re)start: a previous session of this sender
+    if (timestampNanos < floorTimestamp_) return false;
+
+    if (started_) {
+        const std::int32_t ahead = std::int32_t(seq - newest_);
+        if (ahead > 0) {
+            seen_ = (std::uint32_t(ahead) >= WINDOW) ? 0 : seen_ << ahead;
+            seen_ |= 1;
+            newest_ = seq;
+            if (timestampNanos > newestTimestamp_) newestTimestamp_ = timestampNanos;
+            return true;
+        }
+        const std::uint32_t behind = newest_ - seq;
+        if (behind < WINDOW) {
+            const std::uint64_t bit = std::uint64_t(1) << behind;
+            if (seen_ & bit) return false;   // replayed / duplicated
+            seen_ |= bit;
+            if (timestampNanos > newestTimestamp_) newestTimestamp_ = timestampNanos;
+            return true;
+        }
+        if (timestampNanos <= newestTimestamp_) return false;   // too old: replay
+    }
+    started_ = true;
+    newest_ = seq;
+    seen_ = 1;
+    newestTimestamp_ = timestampNanos;
+    floorTimestamp_ = timestampNanos;
+    return true;
+}
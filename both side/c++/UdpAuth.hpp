@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "UdpWire.hpp"
+
+// Per-datagram authentication shared by UdpDoubleSender / UdpDoubleReceiver.
+//
+// With a shared 16-byte key configured on both sides every datagram (frames,
+// handshakes, bulk chunks, reports, ACKs) carries an 8-byte tag trailer:
+//
+//   [0..n)    datagram as without authentication
+//   [n..n+8)  tag (BE) over bytes [0..n)
+//
+// The tag is UMAC-style: the datagram is compressed by NH, a keyed
+// universal hash costing one SIMD multiply per 16 bytes (SSE2; AVX2 when
+// compiled for it), run twice with Toeplitz-shifted keys (collision chance
+// about 2^-64); the two NH sums and the length are then tagged with
+// SipHash-2-4. Over a 172-double frame this is 7-15x cheaper than SipHash
+// alone. All keys are derived from the shared key.
+//
+// Frames additionally pass a ReplayWindow on seq (see below), one per
+// sender address:port.
+class UdpAuth {
+public:
+    static constexpr std::size_t KEY_BYTES = 16;
+    static constexpr std::size_t TAG_BYTES = 8;
+    static constexpr std::size_t MAX_BYTES = 65536;   // largest datagram covered
+
+    explicit UdpAuth(const std::uint8_t key[KEY_BYTES]);
+
+    std::uint64_t tag(const std::uint8_t* p, std::size_t n) const;
+    // tag() through the scalar NH path only; reference for the SIMD paths.
+    std::uint64_t tagScalar(const std::uint8_t* p, std::size_t n) const;
+    // Writes the tag trailer at p + n (room for TAG_BYTES required).
+    void sign(std::uint8_t* p, std::size_t n) const;
+    // n includes the trailer. False for a wrong tag or a short datagram.
+    bool verify(const std::uint8_t* p, std::size_t n) const;
+
+    static std::uint64_t sipHash24(std::uint64_t k0, std::uint64_t k1, const std::uint8_t* p, std::size_t n);
+
+    // Session start ("UDPN"): negotiate() answers an ACK that carries a
+    // challenge (authenticated receivers issue a fresh one per HELLO) with
+    //
+    //   [0..19]  header (BE: magic, version=1, count=0, seq=HELLO nonce,
+    //            ts=sender's frame clock now)
+    //   [20..27] the challenge
+    //
+    // A tagged SESSION echoing the outstanding challenge can only come from
+    // a key holder after that ACK, so the receiver restarts the sender's
+    // window at ts (ReplayWindow::restart) even if the sender rebooted and
+    // its clock went backwards. Each challenge is accepted once.
+    static constexpr std::uint32_t MAGIC_SESSION = 0x5544504Eu; // "UDPN"
+    static constexpr std::size_t   SESSION_BYTES = 28;
+
+    static void encodeSession(std::uint8_t* dst, std::uint32_t nonce, std::uint64_t timestampNanos,
+                              std::uint64_t challenge) {
+        UdpWire::put32(dst + 0, MAGIC_SESSION);
+        UdpWire::put16(dst + 4, 1);
+        UdpWire::put16(dst + 6, 0);
+        UdpWire::put32(dst + 8, nonce);
+        UdpWire::put64(dst + 12, timestampNanos);
+        UdpWire::put64(dst + 20, challenge);
+    }
+
+    static bool decodeSession(const std::uint8_t* p, std::size_t n, std::uint64_t& timestampNanos,
+                              std::uint64_t& challenge) {
+        if (n < SESSION_BYTES || UdpWire::get32(p) != MAGIC_SESSION) return false;
+        timestampNanos = UdpWire::get64(p + 12);
+        challenge = UdpWire::get64(p + 20);
+        return true;
+    }
+
+    // Sliding window over frame seq numbers (IPsec style): accepts each seq
+    // once, and nothing more than WINDOW behind the newest. A frame behind
+    // the window whose sender timestamp is newer than any accepted so far
+    // restarts the window: the sender restarted (its steady_clock kept
+    // running), whereas a replay carries an old, authenticated timestamp.
+    // A rebooted sender's clock starts lower; it restarts the window with a
+    // SESSION instead. Frames stamped before the last (re)start are refused,
+    // so frames of an earlier session cannot be replayed ahead of the new one.
+    class ReplayWindow {
+    public:
+        static constexpr std::uint32_t WINDOW = 64;
+
+        bool accept(std::uint32_t seq, std::uint64_t timestampNanos);
+        void reset() { started_ = false; floorTimestamp_ = 0; }
+        // New session: the next frame stamped at or after floorTimestamp
+        // starts the window, earlier ones are refused.
+        void restart(std::uint64_t floorTimestamp) { started_ = false; floorTimestamp_ = floorTimestamp; }
+
+    private:
+        bool started_ = false;
+        std::uint32_t newest_ = 0;
+        std::uint64_t seen_ = 0;              // bit i: newest_ - i accepted
+        std::uint64_t newestTimestamp_ = 0;
+        std::uint64_t floorTimestamp_ = 0;    // timestamp of the (re)start frame
+    };
+
+private:
+    std::uint64_t nh(const std::uint8_t* p, std::size_t n, std::uint64_t& second) const;
+    std::uint64_t nhScalar(const std::uint8_t* p, std::size_t n, std::uint64_t& second) const;
+    // SipHash over both NH sums and the length
+    std::uint64_t finish(std::uint64_t a, std::uint64_t b, std::size_t n) const;
+
+private:
+    std::uint64_t k0_ = 0, k1_ = 0;             // SipHash key for the final tag
+    std::vector<std::uint32_t> nhKey_;          // MAX_BYTES / 4 + 4 words
+};
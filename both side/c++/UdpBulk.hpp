@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "UdpWire.hpp"
+
+// Bulk transfer messages (trajectories, parameter sets) shared by
+// BulkSender and UdpDoubleReceiver. Always big-endian.
+//
+// CHUNK ("UDPB"), count = doubles in this chunk, seq = chunk index,
+// ts = sender send time (echoed in the ACK for RTT):
+//   [0..19]  standard UDPD header
+//   [20..23] transferId      [24..27] totalChunks
+//   [28..31] totalDoubles    [32..35] crc32 of all payload bytes
+//   [36..39] chunkDoubles (nominal; the last chunk may be shorter)
+//   [40..]   doubles (BE)
+//
+// ACK ("UDPK"), count = 0, seq = transferId, ts = echoed chunk ts:
+//   [20..23] cumulative: every chunk < this was received
+//   [24..25] flags (COMPLETE, CRC_FAILED)  [26..27] sackWords
+//   [28..]   sackWords x 64-bit bitmap; bit i = chunk cumulative + 1 + i
+//
+// Peers that do not know these magics drop them.
+struct UdpBulk {
+    static constexpr std::uint32_t MAGIC_CHUNK = 0x55445042u; // "UDPB"
+    static constexpr std::uint32_t MAGIC_ACK   = 0x5544504Bu; // "UDPK"
+    static constexpr std::size_t   HEADER_BYTES = 20;
+    static constexpr std::size_t   CHUNK_HEADER_BYTES = 40;
+    static constexpr std::size_t   ACK_HEADER_BYTES = 28;
+    static constexpr std::size_t   MAX_SACK_WORDS = 4;
+
+    enum : std::uint16_t { FLAG_COMPLETE = 1, FLAG_CRC_FAILED = 2 };
+
+    struct Chunk {
+        std::uint32_t index = 0;
+        std::uint64_t sentNanos = 0;
+        std::uint32_t transferId = 0;
+        std::uint32_t totalChunks = 0;
+        std::uint32_t totalDoubles = 0;
+        std::uint32_t crc = 0;
+        std::uint32_t chunkDoubles = 0;
+        std::uint16_t count = 0;
+        const std::uint8_t* payload = nullptr;   // count BE doubles
+    };
+
+    struct Ack {
+        std::uint32_t transferId = 0;
+        std::uint64_t echoNanos = 0;
+        std::uint32_t cumulative = 0;
+        std::uint16_t flags = 0;
+        std::uint16_t sackWords = 0;
+        std::uint64_t sack[MAX_SACK_WORDS] = {0, 0, 0, 0};
+    };
+
+    // Header only; the caller writes c.count BE doubles at dst + CHUNK_HEADER_BYTES.
+    static void encodeChunkHeader(std::uint8_t* dst, const Chunk& c) {
+        UdpWire::put32(dst + 0, MAGIC_CHUNK);
+        UdpWire::put16(dst + 4, 1);
+        UdpWire::put16(dst + 6, c.count);
+        UdpWire::put32(dst + 8, c.index);
+        UdpWire::put64(dst + 12, c.sentNanos);
+        UdpWire::put32(dst + 20, c.transferId);
+        UdpWire::put32(dst + 24, c.totalChunks);
+        UdpWire::put32(dst + 28, c.totalDoubles);
+        UdpWire::put32(dst + 32, c.crc);
+        UdpWire::put32(dst + 36, c.chunkDoubles);
+    }
+
+    static bool decodeChunk(const std::uint8_t* p, std::size_t n, Chunk& c) {
+        if (n < CHUNK_HEADER_BYTES || UdpWire::get32(p) != MAGIC_CHUNK) return false;
+        c.count = UdpWire::get16(p + 6);
+        c.index = UdpWire::get32(p + 8);
+        c.sentNanos = UdpWire::get64(p + 12);
+        c.transferId = UdpWire::get32(p + 20);
+        c.totalChunks = UdpWire::get32(p + 24);
+        c.totalDoubles = UdpWire::get32(p + 28);
+        c.crc = UdpWire::get32(p + 32);
+        c.chunkDoubles = UdpWire::get32(p + 36);
+        c.payload = p + CHUNK_HEADER_BYTES;
+        return n >= CHUNK_HEADER_BYTES + std::size_t(c.count) * 8;
+    }
+
+    static std::size_t encodeAck(std::uint8_t* dst, const Ack& a) {
+        UdpWire::put32(dst + 0, MAGIC_ACK);
+        UdpWire::put16(dst + 4, 1);
+        UdpWire::put16(dst + 6, 0);
+        UdpWire::put32(dst + 8, a.transferId);
+        UdpWire::put64(dst + 12, a.echoNanos);
+        UdpWire::put32(dst + 20, a.cumulative);
+        UdpWire::put16(dst + 24, a.flags);
+        UdpWire::put16(dst + 26, a.sackWords);
+        for (std::size_t w = 0; w < a.sackWords; ++w) UdpWire::put64(dst + ACK_HEADER_BYTES + w * 8, a.sack[w]);
+        return ACK_HEADER_BYTES + std::size_t(a.sackWords) * 8;
+    }
+
+    static bool decodeAck(const std::uint8_t* p, std::size_t n, Ack& a) {
+        if (n < ACK_HEADER_BYTES || UdpWire::get32(p) != MAGIC_ACK) return false;
+        a.transferId = UdpWire::get32(p + 8);
+        a.echoNanos = UdpWire::get64(p + 12);
+        a.cumulative = UdpWire::get32(p + 20);
+        a.flags = UdpWire::get16(p + 24);
+        a.sackWords = UdpWire::get16(p + 26);
+        if (a.sackWords > MAX_SACK_WORDS || n < ACK_HEADER_BYTES + std::size_t(a.sackWords) * 8) return false;
+        for (std::size_t w = 0; w < a.sackWords; ++w) a.sack[w] = UdpWire::get64(p + ACK_HEADER_BYTES + w * 8);
+        return true;
+    }
+
+    // CRC-32 (IEEE 802.3, reflected). Pass the previous result to continue.
+    static std::uint32_t crc32(const std::uint8_t* p, std::size_t n, std::uint32_t crc = 0) {
+        static const CrcTable table;
+        crc = ~crc;
+        for (std::size_t i = 0; i < n; ++i) crc = table.v[(crc ^ p[i]) & 0xFFu] ^ (crc >> 8);
+        return ~crc;
+    }
+
+private:
+    struct CrcTable {
+        std::uint32_t v[256];
+        CrcTable() {
+            for (std::uint32_t i = 0; i < 256; ++i) {
+                std::uint32_t c = i;
+                for (int k = 0; k < 8; ++k) c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                v[i] = c;
+            }
+        }
+    };
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "UdpWire.hpp"
+
+// In-band capability handshake shared by UdpDoubleSender / UdpDoubleReceiver.
+//
+// The sender sends HELLO ("UDPH") with its capabilities, the receiver answers
+// ACK ("UDPA") echoing the nonce (header seq) with its own capabilities and
+// the chosen encoding. Both messages are always big-endian, count = 0:
+//
+//   [0..19]  standard UDPD header (magic, version=1, count=0, seq=nonce,
+//            ts: ACK from an authenticated receiver: session challenge
+//            (UdpAuth::MAGIC_SESSION), else 0)
+//   [20..21] minVersion       [22..23] maxVersion
+//   [24]     byteOrders       [25]     elementTypes
+//   [26]     compression      [27]     reserved
+//   [28..29] maxPayloadBytes  [30..31] maxChannels
+//   [32]     chosenOrder      [33]     chosenElement
+//   [34]     chosenCompression [35]    chosenVersion (0 = incompatible)
+//
+// Peers that do not know these magics (e.g. the Java side) just drop them.
+struct UdpCapabilities {
+    static constexpr std::uint32_t MAGIC_HELLO = 0x55445048u; // "UDPH"
+    static constexpr std::uint32_t MAGIC_ACK   = 0x55445041u; // "UDPA"
+    static constexpr std::size_t   HEADER_BYTES = 20;
+    static constexpr std::size_t   MESSAGE_BYTES = HEADER_BYTES + 16;
+
+    enum : std::uint8_t { ORDER_BIG = 1, ORDER_LITTLE = 2 };
+    enum : std::uint8_t { ELEM_F64 = 1 };
+    enum : std::uint8_t { COMP_SPARSE = 1, COMP_PREVIEW = 2, COMP_APPLY_AT = 4 };   // "UDPS" / "UDPT" / "UDPE" frames
+
+    std::uint16_t minVersion = 1;
+    std::uint16_t maxVersion = 1;
+    std::uint8_t  byteOrders = ORDER_BIG;
+    std::uint8_t  elementTypes = ELEM_F64;
+    std::uint8_t  compression = 0;
+    std::uint16_t maxPayloadBytes = 0;
+    std::uint16_t maxChannels = 0;
+
+    // ACK only
+    std::uint8_t  chosenOrder = 0;
+    std::uint8_t  chosenElement = 0;
+    std::uint8_t  chosenCompression = 0;
+    std::uint8_t  chosenVersion = 0;
+    std::uint64_t challenge = 0;      // header ts, see above
+
+    static void encode(std::uint8_t* dst, std::uint32_t magic, std::uint32_t nonce, const UdpCapabilities& c) {
+        UdpWire::put32(dst + 0, magic);
+        UdpWire::put16(dst + 4, 1);
+        UdpWire::put16(dst + 6, 0);
+        UdpWire::put32(dst + 8, nonce);
+        UdpWire::put64(dst + 12, c.challenge);
+
+        std::uint8_t* p = dst + HEADER_BYTES;
+        UdpWire::put16(p + 0, c.minVersion);
+        UdpWire::put16(p + 2, c.maxVersion);
+        p[4] = c.byteOrders;
+        p[5] = c.elementTypes;
+        p[6] = c.compression;
+        p[7] = 0;
+        UdpWire::put16(p + 8, c.maxPayloadBytes);
+        UdpWire::put16(p + 10, c.maxChannels);
+        p[12] = c.chosenOrder;
+        p[13] = c.chosenElement;
+        p[14] = c.chosenCompression;
+        p[15] = c.chosenVersion;
+    }
+
+    // Returns false unless p holds a HELLO or ACK.
+    static bool decode(const std::uint8_t* p, std::size_t n, std::uint32_t& magic,
+                       std::uint32_t& nonce, UdpCapabilities& c) {
+        if (n < MESSAGE_BYTES) return false;
+        magic = UdpWire::get32(p + 0);
+        if (magic != MAGIC_HELLO && magic != MAGIC_ACK) return false;
+        nonce = UdpWire::get32(p + 8);
+        c.challenge = UdpWire::get64(p + 12);
+
+        const std::uint8_t* q = p + HEADER_BYTES;
+        c.minVersion = UdpWire::get16(q + 0);
+        c.maxVersion = UdpWire::get16(q + 2);
+        c.byteOrders = q[4];
+        c.elementTypes = q[5];
+        c.compression = q[6];
+        c.maxPayloadBytes = UdpWire::get16(q + 8);
+        c.maxChannels = UdpWire::get16(q + 10);
+        c.chosenOrder = q[12];
+        c.chosenElement = q[13];
+        c.chosenCompression = q[14];
+        c.chosenVersion = q[15];
+        return true;
+    }
+
+    // Receiver side: best common encoding for an offer. Prefers the
+    // receiver's native byte order (no swap on decode).
+    static UdpCapabilities choose(const UdpCapabilities& offer, const UdpCapabilities& local, bool hostLittle) {
+        UdpCapabilities r = local;
+
+        const std::uint16_t lo = std::max(offer.minVersion, local.minVersion);
+        const std::uint16_t hi = std::min(offer.maxVersion, local.maxVersion);
+        r.chosenVersion = (lo <= hi) ? std::uint8_t(hi) : 0;
+
+        const std::uint8_t orders = offer.byteOrders & local.byteOrders;
+        const std::uint8_t native = hostLittle ? ORDER_LITTLE : ORDER_BIG;
+        r.chosenOrder = (orders & native) ? native : (orders & ORDER_BIG) ? ORDER_BIG : (orders & ORDER_LITTLE);
+
+        r.chosenElement = (offer.elementTypes & local.elementTypes & ELEM_F64) ? ELEM_F64 : 0;
+        r.chosenCompression = offer.compression & local.compression;
+
+        r.maxPayloadBytes = std::min(offer.maxPayloadBytes, local.maxPayloadBytes);
+        r.maxChannels = std::min(offer.maxChannels, local.maxChannels);
+
+        if (!r.chosenOrder || !r.chosenElement) r.chosenVersion = 0;
+        return r;
+    }
+
+    static const char* orderName(std::uint8_t o) {
+        return o == ORDER_LITTLE ? "LITTLE" : o == ORDER_BIG ? "BIG" : "NONE";
+    }
+};
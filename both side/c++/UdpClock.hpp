@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "UdpWire.hpp"
+
+// Clock sync exchange between UdpDoubleSender and UdpDoubleReceiver (see
+// UdpDoubleSender::syncClock). The sender sends SYNC ("UDPC") stamped with
+// its steady_clock; the receiver answers SYNC_REPLY ("UDPY") echoing nonce
+// and stamp, adding its own steady_clock at reception and at reply. Always
+// big-endian, count = 0:
+//
+//   [0..19]  standard UDPD header (seq = nonce, ts = sender send time)
+//   [20..27] receiver receive time   [28..35] receiver reply time
+//
+// With t0..t3 = send, receive, reply, reply arrival the receiver clock is
+// ahead by ((t1 - t0) + (t2 - t3)) / 2, within half the round trip
+// (t3 - t0) - (t2 - t1). Peers that do not know these magics drop them.
+struct UdpClock {
+    static constexpr std::uint32_t MAGIC_SYNC  = 0x55445043u; // "UDPC"
+    static constexpr std::uint32_t MAGIC_REPLY = 0x55445059u; // "UDPY"
+    static constexpr std::size_t   HEADER_BYTES = 20;
+    static constexpr std::size_t   MESSAGE_BYTES = HEADER_BYTES + 16;
+
+    std::uint32_t nonce = 0;
+    std::int64_t  senderNanos = 0;     // t0
+    std::int64_t  receiveNanos = 0;    // t1 (reply only)
+    std::int64_t  replyNanos = 0;      // t2 (reply only)
+
+    static void encode(std::uint8_t* dst, std::uint32_t magic, const UdpClock& c) {
+        UdpWire::put32(dst + 0, magic);
+        UdpWire::put16(dst + 4, 1);
+        UdpWire::put16(dst + 6, 0);
+        UdpWire::put32(dst + 8, c.nonce);
+        UdpWire::put64(dst + 12, (std::uint64_t)c.senderNanos);
+        UdpWire::put64(dst + 20, (std::uint64_t)c.receiveNanos);
+        UdpWire::put64(dst + 28, (std::uint64_t)c.replyNanos);
+    }
+
+    // Returns false unless p holds a message with the given magic.
+    static bool decode(const std::uint8_t* p, std::size_t n, std::uint32_t magic, UdpClock& c) {
+        if (n < MESSAGE_BYTES || UdpWire::get32(p) != magic) return false;
+        c.nonce = UdpWire::get32(p + 8);
+        c.senderNanos = (std::int64_t)UdpWire::get64(p + 12);
+        c.receiveNanos = (std::int64_t)UdpWire::get64(p + 20);
+        c.replyNanos = (std::int64_t)UdpWire::get64(p + 28);
+        return true;
+    }
+};
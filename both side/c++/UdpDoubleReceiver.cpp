@@ -8,15 +8,44 @@
 #endif
 
 #include "UdpDoubleReceiver.hpp"
+#include "UdpCapabilities.hpp"
+#include "TimeSeriesStore.hpp"
+#include "FramePipeline.hpp"
+#include "UdpReport.hpp"
+#include "UdpBulk.hpp"
+#include "ReorderBuffer.hpp"
+#include "TriggerEngine.hpp"
+#include "UdpClock.hpp"
+#include "ReceiverIo.hpp"
+#include "ReceiverSimulation.hpp"
 #include <iostream>
 #include <cstring>
 #include <chrono>
+#include <limits>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 #include <ws2tcpip.h>
 
 static constexpr std::uint32_t MAGIC_UDPD = 0x55445044; // 'U''D''P''D'
+static constexpr std::uint32_t MAGIC_UDPS = 0x55445053; // 'U''D''P''S' sparse update
+static constexpr std::uint32_t MAGIC_UDPT = 0x55445054; // 'U''D''P''T' trajectory preview
+static constexpr std::uint32_t MAGIC_UDPE = 0x55445045; // 'U''D''P''E' apply-at frame
 static constexpr std::uint16_t VERSION_1  = 1;
 static constexpr std::size_t   HEADER_BYTES = 20;
 
+static constexpr std::int64_t MAX_IDLE_NANOS = 20'000'000;     // blocked receiver rechecks running_
+static constexpr std::int64_t REORDER_POLL_NANOS = 1'000'000;  // reorder gap timeouts while idle
+static constexpr std::int64_t REJECT_LOG_NANOS = 1'000'000'000; // "rejected" lines at most this often
+static constexpr std::int64_t BULK_IDLE_NANOS = 2'000'000'000;  // 2x BulkSender's max RTO: transfer abandoned
+#if defined(_WIN32)
+static constexpr std::int64_t RELEASE_SPIN_NANOS = 2'000'000;  // sleeps overshoot ~1 ms even at 1 ms timer resolution
+#else
+static constexpr std::int64_t RELEASE_SPIN_NANOS = 200'000;
+#endif
+static constexpr std::int64_t RELEASE_SLICE_NANOS = 50'000;   // longest spin before the socket is read again
+
 UdpDoubleReceiver::UdpDoubleReceiver(const std::string& host,
                                      int port,
                                      std::size_t bufferSize,
@@ -26,10 +55,25 @@ UdpDoubleReceiver::UdpDoubleReceiver(const std::string& host,
       bufferSize_(bufferSize),
       endian_(endian),
       running_(false),
-      sockfd_(INVALID_SOCKET)
+      sockfd_(INVALID_SOCKET),
+      releaseSpinNanos_(RELEASE_SPIN_NANOS)
 {
     if (bufferSize_ < 256) bufferSize_ = 256; // small safety minimum
-    recvBuffer_.resize(bufferSize_);
+
+    hostLittle_ = hostIsLittleEndian();
+
+    maxChannels_ = (bufferSize_ - HEADER_BYTES) / 8;
+    maskWords_ = (maxChannels_ + 63) / 64;
+    subMask_.reset(new std::atomic<std::uint64_t>[maskWords_]);
+    for (std::size_t w = 0; w < maskWords_; ++w) subMask_[w].store(0, std::memory_order_relaxed);
+    subRefs_.assign(maxChannels_, 0);
+    storeRow_.assign(maxChannels_, 0.0);
+    wait_.reset(new WaitStrategy(WaitStrategy::sleep(2'000'000)));
+
+    // single stream for the whole port until enableSourceDemux()
+    spare_ = newSlot();
+    streams_.reset(new std::unique_ptr<Stream>[1]);
+    addStream();
 }
 
 UdpDoubleReceiver::~UdpDoubleReceiver() {
@@ -91,7 +135,7 @@ bool UdpDoubleReceiver::start() {
     receiverThread_ = std::thread(&UdpDoubleReceiver::run, this);
 
     std::cout << "UDP receiver listening on " << host_ << ":" << port_
-              << " (endian=" << (endian_ == Endian::Big ? "BIG" : "LITTLE") << ")\n";
+              << " (endian=" << (endian_ == Endian::Big ? "BIG" : "LITTLE") << " preferred, auto-detect)\n";
     return true;
 }
 
@@ -126,12 +170,389 @@ void UdpDoubleReceiver::stop() {
 }
 
 bool UdpDoubleReceiver::getLatest(Packet& out) {
-    std::lock_guard<std::mutex> lock(dataMutex_);
-    if (!hasData_) return false;
-    out = latest_;   // copy out (safe & simple)
+    return getLatest(0, out);
+}
+
+bool UdpDoubleReceiver::getLatest(int source, Packet& out) {
+    FrameView view;
+    if (!getLatestView(source, view)) return false;
+
+    out.seq = view.seq();
+    out.timestampNanos = view.timestampNanos();
+    out.arrivalNanos = view.arrivalNanos();
+    out.applyAtNanos = view.applyAtNanos();
+    out.data.resize(view.count());   // reuses out's capacity
+    for (std::size_t i = 0; i < out.data.size(); ++i) out.data[i] = view.get(i);
+    return true;
+}
+
+bool UdpDoubleReceiver::getLatestView(FrameView& out) {
+    return getLatestView(0, out);
+}
+
+bool UdpDoubleReceiver::getLatestView(int source, FrameView& out) {
+    if (source < 0 || (std::size_t)source >= streamCount_.load(std::memory_order_acquire)) return false;
+    Stream& st = *streams_[source];
+
+    std::unique_lock<std::mutex> lock(st.readMutex);
+    // check hasData first: once set, the first publish is visible in middle
+    if (!st.hasData.load(std::memory_order_acquire)) return false;
+
+    if (st.middle.load(std::memory_order_acquire) & SLOT_FRESH) {
+        st.frontIndex = st.middle.exchange(st.frontIndex, std::memory_order_acq_rel) & SLOT_MASK;
+    }
+
+    out.lock_ = std::move(lock);
+    out.owner_ = this;
+    out.slot_ = st.slots[st.frontIndex];
+    return true;
+}
+
+// ---------- trajectory preview ----------
+bool UdpDoubleReceiver::getSetpointAt(int source, std::int64_t tNanos, Setpoint& out) {
+    FrameView view;
+    if (!getLatestView(source, view)) return false;
+    const Slot& s = *view.slot_;
+    const std::size_t count = s.count;
+
+    out.seq = s.seq;
+    out.anchorNanos = s.arrivalNanos;
+    out.horizonNanos = s.arrivalNanos;
+    out.fromPreview = false;
+    out.data.resize(count);
+    for (std::size_t i = 0; i < count; ++i) out.data[i] = decodeChannel(s, i);
+
+    // offsets, then one row of float deltas per planned setpoint
+    const std::uint8_t* offsets = s.wire() + HEADER_BYTES + count * 8 + 4;
+    const std::uint8_t* deltas = offsets + std::size_t(s.horizon) * 4;
+    auto pointTime = [&](std::size_t k) { return s.arrivalNanos + (std::int64_t)read32(offsets + k * 4, s.endian); };
+    auto delta = [&](std::size_t k, std::size_t i) {
+        const std::uint32_t bits = read32(deltas + (k * count + i) * 4, s.endian);
+        float f;
+        std::memcpy(&f, &bits, 4);
+        return (double)f;
+    };
+
+    if (s.horizon > 0) out.horizonNanos = pointTime(s.horizon - 1);
+    out.beyondHorizon = tNanos > out.horizonNanos;
+    if (s.horizon == 0 || tNanos <= s.arrivalNanos) return true;
+
+    out.fromPreview = true;
+    if (out.beyondHorizon) {
+        for (std::size_t i = 0; i < count; ++i) out.data[i] += delta(s.horizon - 1, i);
+        return true;
+    }
+
+    // first planned setpoint at or after t; the one before it (or the
+    // current setpoint) starts the segment
+    std::size_t k = 0;
+    while (pointTime(k) < tNanos) ++k;
+    const std::int64_t t0 = (k == 0) ? s.arrivalNanos : pointTime(k - 1);
+    const std::int64_t t1 = pointTime(k);
+    const double w = (t1 > t0) ? (double)(tNanos - t0) / (double)(t1 - t0) : 1.0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const double d0 = (k == 0) ? 0.0 : delta(k - 1, i);
+        out.data[i] += d0 + (delta(k, i) - d0) * w;
+    }
+    return true;
+}
+
+// ---------- source demux ----------
+UdpDoubleReceiver::Slot* UdpDoubleReceiver::newSlot() {
+    std::unique_ptr<Slot> s(new Slot());
+    s->storage.assign((WIRE_OFFSET + bufferSize_ + 7) / 8, 0.0);
+    s->decodedMask.assign(maskWords_, 0);
+    slotStore_.push_back(std::move(s));
+    return slotStore_.back().get();
+}
+
+int UdpDoubleReceiver::addStream() {
+    const std::size_t id = streamCount_.load(std::memory_order_relaxed);
+    if (id >= streamCap_) return -1;
+
+    std::unique_ptr<Stream> st(new Stream());
+    st->id = (int)id;
+    for (Slot*& s : st->slots) s = newSlot();
+    st->state.assign(maxChannels_, 0.0);
+    streams_[id] = std::move(st);
+    streamCount_.store(id + 1, std::memory_order_release);
+    return (int)id;
+}
+
+bool UdpDoubleReceiver::enableSourceDemux(std::size_t maxSources) {
+    if (running_ || maxSources == 0) return false;
+
+    // load factor <= 1/2 even with as many rejected senders cached as streams
+    std::size_t cap = 16;
+    unsigned bits = 4;
+    while (cap < maxSources * 4) { cap <<= 1; ++bits; }
+    table_.reset(new SourceEntry[cap]);
+    tableMask_ = cap - 1;
+    tableShift_ = 64 - bits;
+    tableUsed_ = 0;
+
+    slotStore_.clear();
+    spare_ = newSlot();
+    streams_.reset(new std::unique_ptr<Stream>[maxSources]);
+    streamCap_ = maxSources;
+    streamCount_.store(0, std::memory_order_release);
+    demux_ = true;
+    return true;
+}
+
+bool UdpDoubleReceiver::allowSource(const std::string& ip, std::uint16_t port) {
+    if (running_) return false;
+    in_addr a{};
+    if (inet_pton(AF_INET, ip.c_str(), &a) != 1) {
+        std::cerr << "allowSource: bad address " << ip << "\n";
+        return false;
+    }
+    allowList_.push_back(sourceKey(ntohl(a.s_addr), port));
+    return true;
+}
+
+bool UdpDoubleReceiver::sourceAllowed(std::uint32_t addr, std::uint16_t port) const {
+    if (allowList_.empty()) return true;
+    const std::uint64_t exact = sourceKey(addr, port);
+    const std::uint64_t anyPort = sourceKey(addr, 0);
+    for (std::uint64_t k : allowList_)
+        if (k == exact || k == anyPort) return true;
+    return false;
+}
+
+UdpDoubleReceiver::Stream* UdpDoubleReceiver::streamFor(const sockaddr_in& from) {
+    const std::uint64_t key = sourceKey(ntohl(from.sin_addr.s_addr), ntohs(from.sin_port));
+    if (!demux_) {
+        Stream* st = streams_[0].get();
+        st->source.store(key, std::memory_order_relaxed);
+        return st;
+    }
+
+    // receiver is the only writer, so relaxed loads suffice here
+    std::size_t i = tableIndex(key);
+    for (;;) {
+        const std::uint64_t k = table_[i].key.load(std::memory_order_relaxed);
+        if (k == key) {
+            const std::int32_t id = table_[i].stream.load(std::memory_order_relaxed);
+            if (id < 0) {
+                rejectedPackets_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            return streams_[id].get();
+        }
+        if (k == 0) break;
+        i = (i + 1) & tableMask_;
+    }
+
+    // new sender
+    int id = -1;
+    if (sourceAllowed(ntohl(from.sin_addr.s_addr), ntohs(from.sin_port))) id = addStream();
+
+    char ip[INET_ADDRSTRLEN] = {0};
+    inet_ntop(AF_INET, &from.sin_addr, ip, sizeof(ip));
+    if (id >= 0) {
+        streams_[id]->source.store(key, std::memory_order_relaxed);
+        std::cout << "Source " << ip << ":" << ntohs(from.sin_port) << " -> stream " << id << "\n";
+    } else {
+        rejectedPackets_.fetch_add(1, std::memory_order_relaxed);
+        // at most one line per interval, however many senders are turned away
+        ++rejectsUnlogged_;
+        const std::int64_t now = clockNanos();
+        if (now - lastRejectLog_ >= REJECT_LOG_NANOS) {
+            std::cerr << "Source " << ip << ":" << ntohs(from.sin_port) << " rejected";
+            if (rejectsUnlogged_ > 1) std::cerr << " (" << rejectsUnlogged_ << " rejected since the last message)";
+            std::cerr << "\n";
+            lastRejectLog_ = now;
+            rejectsUnlogged_ = 0;
+        }
+    }
+
+    // Streams always fit (<= 1/4 of the table); rejected senders are cached
+    // while the table stays at most half full, else re-checked per packet.
+    if (id >= 0 || tableUsed_ < (tableMask_ + 1) / 2) {
+        table_[i].stream.store(id, std::memory_order_relaxed);
+        table_[i].key.store(key, std::memory_order_release);
+        ++tableUsed_;
+    }
+    return (id >= 0) ? streams_[id].get() : nullptr;
+}
+
+bool UdpDoubleReceiver::attachStore(TimeSeriesStore* store, int source) {
+    if (source < 0 || (std::size_t)source >= streamCount_.load(std::memory_order_acquire)) return false;
+    streams_[source]->store.store(store, std::memory_order_release);
+    return true;
+}
+
+bool UdpDoubleReceiver::attachPipeline(FramePipeline* pipeline, int source) {
+    if (source < 0 || (std::size_t)source >= streamCount_.load(std::memory_order_acquire)) return false;
+    streams_[source]->pipeline.store(pipeline, std::memory_order_release);
     return true;
 }
 
+bool UdpDoubleReceiver::attachReorder(ReorderBuffer* reorder, int source) {
+    if (source < 0 || (std::size_t)source >= streamCount_.load(std::memory_order_acquire)) return false;
+    streams_[source]->reorder.store(reorder, std::memory_order_release);
+    if (reorder) anyReorder_.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool UdpDoubleReceiver::attachTriggers(TriggerEngine* triggers, int source) {
+    if (source < 0 || (std::size_t)source >= streamCount_.load(std::memory_order_acquire)) return false;
+    streams_[source]->triggers.store(triggers, std::memory_order_release);
+    return true;
+}
+
+int UdpDoubleReceiver::findSource(const std::string& ip, std::uint16_t port) const {
+    in_addr a{};
+    if (inet_pton(AF_INET, ip.c_str(), &a) != 1) return -1;
+    if (!demux_) return 0;
+
+    const std::uint64_t key = sourceKey(ntohl(a.s_addr), port);
+    for (std::size_t i = tableIndex(key);; i = (i + 1) & tableMask_) {
+        const std::uint64_t k = table_[i].key.load(std::memory_order_acquire);
+        if (k == key) return table_[i].stream.load(std::memory_order_relaxed);
+        if (k == 0) return -1;
+    }
+}
+
+std::vector<UdpDoubleReceiver::SourceInfo> UdpDoubleReceiver::getSources() const {
+    std::vector<SourceInfo> out;
+    const std::size_t n = streamCount_.load(std::memory_order_acquire);
+    for (std::size_t id = 0; id < n; ++id) {
+        const Stream& st = *streams_[id];
+        SourceInfo info;
+        info.id = (int)id;
+        const std::uint64_t key = st.source.load(std::memory_order_relaxed);
+        if (key) {
+            in_addr a{};
+            a.s_addr = htonl(std::uint32_t(key >> 16));
+            char ip[INET_ADDRSTRLEN] = {0};
+            inet_ntop(AF_INET, &a, ip, sizeof(ip));
+            info.address = std::string(ip) + ":" + std::to_string(std::uint16_t(key));
+        }
+        info.received = st.received.load(std::memory_order_relaxed);
+        info.lost = st.lost.load(std::memory_order_relaxed);
+        info.lateOrDuplicate = st.lateOrDup.load(std::memory_order_relaxed);
+        info.lastSeq = st.lastSeqSeen.load(std::memory_order_relaxed);
+        info.lastArrivalNanos = st.lastArrival.load(std::memory_order_relaxed);
+        info.jitterNanos = st.jitter.load(std::memory_order_relaxed);
+        info.overwritten = st.overwritten.load(std::memory_order_relaxed);
+        out.push_back(info);
+    }
+    return out;
+}
+
+bool UdpDoubleReceiver::trackSeq(Stream& st, std::uint32_t seq, std::uint64_t ts, std::int64_t arrival) {
+    if (st.haveSeq) {
+        const std::int32_t d = std::int32_t(seq - st.lastSeq);   // wraps with the sender's seq
+        if (d <= 0) {
+            st.lateOrDup.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (d > 1) st.lost.fetch_add(std::uint64_t(d - 1), std::memory_order_relaxed);
+
+        // J += (|D| - J) / 16 over in-order frames; clock offsets cancel in D
+        const std::int64_t transit = arrival - (std::int64_t)ts;
+        std::int64_t diff = transit - st.lastTransit;
+        if (diff < 0) diff = -diff;
+        const std::int64_t j = st.jitter.load(std::memory_order_relaxed);
+        st.jitter.store(j + (diff - j) / 16, std::memory_order_relaxed);
+    }
+    st.haveSeq = true;
+    st.lastSeq = seq;
+    st.lastTransit = arrival - (std::int64_t)ts;
+    st.lastSeqSeen.store(seq, std::memory_order_relaxed);
+    return true;
+}
+
+void UdpDoubleReceiver::enableReports(int intervalMs) {
+    if (running_) return;
+    reportIntervalNanos_ = (intervalMs > 0) ? std::int64_t(intervalMs) * 1000000 : 0;
+}
+
+void UdpDoubleReceiver::sendReports(std::int64_t now) {
+    nextReportNanos_ = now + reportIntervalNanos_;
+
+    const std::size_t n = streamCount_.load(std::memory_order_relaxed);
+    for (std::size_t id = 0; id < n; ++id) {
+        Stream& st = *streams_[id];
+        const std::uint64_t key = st.source.load(std::memory_order_relaxed);
+        const std::uint32_t received = (std::uint32_t)st.received.load(std::memory_order_relaxed);
+        if (!key || received == st.reportedReceived) continue;   // silent senders get no report
+        st.reportedReceived = received;
+
+        UdpReport r;
+        r.reportSeq = ++reportSeq_;
+        r.receiverNanos = (std::uint64_t)now;
+        r.highestSeq = st.lastSeq;
+        r.received = received;
+        r.lost = (std::uint32_t)st.lost.load(std::memory_order_relaxed);
+        r.lateOrDuplicate = (std::uint32_t)st.lateOrDup.load(std::memory_order_relaxed);
+        r.jitterMicros = (std::uint32_t)(st.jitter.load(std::memory_order_relaxed) / 1000);
+        r.intervalMillis = (std::uint16_t)std::min<std::int64_t>(reportIntervalNanos_ / 1000000, 0xFFFF);
+        r.overwritten = (std::uint32_t)st.overwritten.load(std::memory_order_relaxed);
+        if (FramePipeline* pl = st.pipeline.load(std::memory_order_relaxed))
+            r.pressurePermille = (std::uint16_t)pl->pressurePermille();
+
+        std::uint8_t msg[UdpReport::MESSAGE_BYTES + UdpAuth::TAG_BYTES];
+        UdpReport::encode(msg, r);
+
+        sockaddr_in to{};
+        to.sin_family = AF_INET;
+        to.sin_addr.s_addr = htonl(std::uint32_t(key >> 16));
+        to.sin_port = htons(std::uint16_t(key));
+        sendReply(msg, UdpReport::MESSAGE_BYTES, to);
+    }
+}
+
+double UdpDoubleReceiver::decodeChannel(const Slot& s, std::size_t i) const {
+    if (s.isDecoded(i)) return s.values()[i];
+    return readDouble(s.wire() + HEADER_BYTES + i * 8, s.endian);
+}
+
+void UdpDoubleReceiver::FrameView::decode(const std::uint16_t* indices, std::size_t n, double* out) const {
+    const std::size_t count = slot_->count;
+    for (std::size_t k = 0; k < n; ++k) {
+        out[k] = (indices[k] < count) ? owner_->decodeChannel(*slot_, indices[k])
+                                      : std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+int UdpDoubleReceiver::subscribeChannels(const std::vector<std::uint16_t>& channels) {
+    std::lock_guard<std::mutex> lock(subMutex_);
+    std::vector<std::uint16_t> kept;
+    for (std::uint16_t ch : channels) {
+        if (ch < maxChannels_) kept.push_back(ch);
+    }
+    for (std::uint16_t ch : kept) ++subRefs_[ch];
+    const int id = nextSubId_++;
+    subscriptions_[id] = std::move(kept);
+    rebuildSubscriptionMask();
+    return id;
+}
+
+void UdpDoubleReceiver::unsubscribeChannels(int id) {
+    std::lock_guard<std::mutex> lock(subMutex_);
+    auto it = subscriptions_.find(id);
+    if (it == subscriptions_.end()) return;
+    for (std::uint16_t ch : it->second) --subRefs_[ch];
+    subscriptions_.erase(it);
+    rebuildSubscriptionMask();
+}
+
+void UdpDoubleReceiver::rebuildSubscriptionMask() {
+    bool any = false;
+    for (std::size_t w = 0; w < maskWords_; ++w) {
+        std::uint64_t bits = 0;
+        for (std::size_t b = 0; b < 64 && w * 64 + b < maxChannels_; ++b) {
+            if (subRefs_[w * 64 + b] > 0) bits |= (std::uint64_t(1) << b);
+        }
+        subMask_[w].store(bits, std::memory_order_relaxed);
+        any = any || bits != 0;
+    }
+    anySubscribed_.store(any, std::memory_order_release);
+}
+
 std::uint16_t UdpDoubleReceiver::read16(const std::uint8_t* p, Endian e) {
     if (e == Endian::Big) {
         return (std::uint16_t(p[0]) << 8) | std::uint16_t(p[1]);
@@ -171,68 +592,694 @@ double UdpDoubleReceiver::readDouble(const std::uint8_t* p, Endian e) {
     return d;
 }
 
+bool UdpDoubleReceiver::hostIsLittleEndian() {
+    const std::uint16_t one = 1;
+    std::uint8_t b;
+    std::memcpy(&b, &one, 1);
+    return b == 1;
+}
+
+unsigned UdpDoubleReceiver::ctz64(std::uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, v);
+    return (unsigned)idx;
+#else
+    return (unsigned)__builtin_ctzll(v);
+#endif
+}
+
+void UdpDoubleReceiver::swapDoublesInPlace(std::uint8_t* p, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint64_t v;
+        std::memcpy(&v, p + i * 8, 8);
+#if defined(_MSC_VER)
+        v = _byteswap_uint64(v);
+#else
+        v = __builtin_bswap64(v);
+#endif
+        std::memcpy(p + i * 8, &v, 8);
+    }
+}
+
+bool UdpDoubleReceiver::frameComplete(std::uint32_t magic, const std::uint8_t* p, std::size_t received,
+                                      std::uint16_t count, Endian e) const {
+    if (count > maxChannels_) return false;
+    std::size_t expected = HEADER_BYTES;
+    if (magic == MAGIC_UDPS) {
+        const std::size_t bitmapBytes = ((std::size_t(count) + 63) / 64) * 8;
+        if (expected + bitmapBytes > received) return false;
+        const std::uint8_t* bitmap = p + expected;
+        std::size_t changed = 0;
+        for (std::size_t b = 0; b < bitmapBytes; ++b) {
+            std::uint8_t v = bitmap[b];
+            while (v) { ++changed; v &= v - 1; }
+        }
+        return expected + bitmapBytes + changed * 8 <= received;
+    }
+
+    expected += std::size_t(count) * 8;
+    if (magic == MAGIC_UDPT) {
+        if (expected + 4 > received) return false;
+        const std::uint16_t horizon = read16(p + expected, e);
+        expected += 4 + std::size_t(horizon) * (4 + std::size_t(count) * 4);
+    } else if (magic == MAGIC_UDPE) {
+        expected += 8;
+    }
+    return expected <= received;
+}
+
+bool UdpDoubleReceiver::mergeSparse(Stream& st, Slot& slot, const std::uint8_t* p, std::uint16_t count) {
+    if (!st.stateValid || count != st.stateCount) return false;
+
+    const std::size_t bitmapBytes = ((std::size_t(count) + 63) / 64) * 8;
+    const std::uint8_t* bitmap = p + HEADER_BYTES;
+    const std::uint8_t* vals = bitmap + bitmapBytes;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (bitmap[i >> 3] & (1u << (i & 7))) {
+            st.state[i] = readDouble(vals, slot.endian);
+            vals += 8;
+        }
+    }
+
+    // Publish the merged state; the slot no longer holds wire payload.
+    std::memcpy(slot.values(), st.state.data(), std::size_t(count) * 8);
+    slot.allDecoded = true;
+    return true;
+}
+
+// ---------- bulk transfer ----------
+void UdpDoubleReceiver::enableBulk(std::size_t maxDoubles) {
+    if (running_) return;
+    bulkMaxDoubles_ = maxDoubles;
+}
+
+bool UdpDoubleReceiver::takeBulk(std::vector<double>& out, std::uint32_t* transferId) {
+    std::lock_guard<std::mutex> lock(bulkMutex_);
+    if (completed_.empty()) return false;
+    if (transferId) *transferId = completed_.front().first;
+    out = std::move(completed_.front().second);
+    completed_.pop_front();
+    return true;
+}
+
+void UdpDoubleReceiver::handleBulkChunk(const std::uint8_t* p, std::size_t received, const sockaddr_in& from,
+                                        std::int64_t now) {
+    UdpBulk::Chunk c;
+    if (!UdpBulk::decodeChunk(p, received, c)) return;
+    if (c.totalDoubles == 0 || c.totalDoubles > bulkMaxDoubles_ || c.chunkDoubles == 0) return;
+    if (c.totalChunks != (c.totalDoubles + c.chunkDoubles - 1) / c.chunkDoubles || c.index >= c.totalChunks) return;
+    const std::size_t first = std::size_t(c.index) * c.chunkDoubles;
+    if (c.count != std::min<std::size_t>(c.chunkDoubles, c.totalDoubles - first)) return;
+
+    // With auth, chunks must be stamped after this sender's last completed
+    // transfer (and its session start), so a captured upload cannot be
+    // replayed once it is no longer the last one.
+    ReplaySource* rs = nullptr;
+    if (auth_) {
+        rs = &replaySource(from, now);
+        if (c.sentNanos <= rs->bulkFloor) {
+            replayRejected_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    const std::uint64_t key = sourceKey(ntohl(from.sin_addr.s_addr), ntohs(from.sin_port));
+    BulkState& b = bulk_;
+    UdpBulk::Ack ack;
+    ack.transferId = c.transferId;
+    ack.echoNanos = c.sentNanos;
+
+    if (key == b.doneSource && c.transferId == b.doneId) {
+        // duplicate of a finished transfer: the final ACK was probably lost
+        ack.cumulative = c.totalChunks;
+        ack.flags = b.doneFlags;
+    } else {
+        if (!b.active || b.id != c.transferId || b.source != key) {
+            // One transfer at a time: a stray or stale chunk must not
+            // discard it. Only its own sender moving on to a newer id, or
+            // BULK_IDLE_NANOS without a chunk, frees it; anyone else gets
+            // no ACK and retries after its RTO.
+            const bool supersedes = key == b.source && std::int32_t(c.transferId - b.id) > 0;
+            if (b.active && !supersedes && now - b.lastChunkNanos < BULK_IDLE_NANOS) return;
+            b.active = true;
+            b.source = key;
+            b.id = c.transferId;
+            b.totalChunks = c.totalChunks;
+            b.totalDoubles = c.totalDoubles;
+            b.chunkDoubles = c.chunkDoubles;
+            b.crc = c.crc;
+            b.received = 0;
+            b.cumulative = 0;
+            b.newestSent = 0;
+            b.bytes.assign(std::size_t(c.totalDoubles) * 8, 0);
+            b.have.assign((c.totalChunks + 63) / 64, 0);
+        }
+        if (c.totalChunks != b.totalChunks || c.totalDoubles != b.totalDoubles || c.chunkDoubles != b.chunkDoubles) return;
+        b.lastChunkNanos = now;
+        if (c.sentNanos > b.newestSent) b.newestSent = c.sentNanos;
+
+        std::uint64_t& word = b.have[c.index >> 6];
+        const std::uint64_t bit = std::uint64_t(1) << (c.index & 63);
+        if (!(word & bit)) {
+            word |= bit;
+            ++b.received;
+            std::memcpy(b.bytes.data() + first * 8, c.payload, std::size_t(c.count) * 8);
+            while (b.cumulative < b.totalChunks && ((b.have[b.cumulative >> 6] >> (b.cumulative & 63)) & 1u))
+                ++b.cumulative;
+        }
+
+        if (b.received == b.totalChunks) {
+            const bool ok = UdpBulk::crc32(b.bytes.data(), b.bytes.size()) == b.crc;
+            ack.flags = ok ? UdpBulk::FLAG_COMPLETE : UdpBulk::FLAG_CRC_FAILED;
+            if (ok) {
+                std::vector<double> values(b.totalDoubles);
+                for (std::size_t i = 0; i < values.size(); ++i) values[i] = readDouble(b.bytes.data() + i * 8, Endian::Big);
+                std::lock_guard<std::mutex> lock(bulkMutex_);
+                completed_.emplace_back(b.id, std::move(values));
+            } else {
+                std::cerr << "Bulk transfer " << b.id << ": CRC mismatch, discarded\n";
+            }
+            b.doneSource = b.source;
+            b.doneId = b.id;
+            b.doneFlags = ack.flags;
+            b.active = false;
+            if (rs) rs->bulkFloor = b.newestSent;
+            b.bytes = std::vector<std::uint8_t>();
+            ack.cumulative = b.totalChunks;
+        } else {
+            // SACK the chunks after the first hole
+            ack.cumulative = b.cumulative;
+            for (std::size_t w = 0; w < UdpBulk::MAX_SACK_WORDS; ++w) {
+                std::uint64_t bits = 0;
+                for (std::uint32_t k = 0; k < 64; ++k) {
+                    const std::uint64_t idx = std::uint64_t(b.cumulative) + 1 + w * 64 + k;
+                    if (idx >= b.totalChunks) break;
+                    if ((b.have[idx >> 6] >> (idx & 63)) & 1u) bits |= std::uint64_t(1) << k;
+                }
+                if (bits) ack.sackWords = std::uint16_t(w + 1);
+                ack.sack[w] = bits;
+            }
+        }
+    }
+
+    std::uint8_t msg[UdpBulk::ACK_HEADER_BYTES + UdpBulk::MAX_SACK_WORDS * 8 + UdpAuth::TAG_BYTES];
+    const std::size_t n = UdpBulk::encodeAck(msg, ack);
+    sendReply(msg, n, from);
+}
+
+void UdpDoubleReceiver::answerHello(const std::uint8_t* p, std::size_t received, const sockaddr_in& from) {
+    std::uint32_t magic = 0, nonce = 0;
+    UdpCapabilities offer;
+    if (!UdpCapabilities::decode(p, received, magic, nonce, offer) || magic != UdpCapabilities::MAGIC_HELLO)
+        return;
+
+    UdpCapabilities local;
+    local.byteOrders = UdpCapabilities::ORDER_BIG | UdpCapabilities::ORDER_LITTLE;
+    local.elementTypes = UdpCapabilities::ELEM_F64;
+    local.compression = UdpCapabilities::COMP_SPARSE | UdpCapabilities::COMP_PREVIEW | UdpCapabilities::COMP_APPLY_AT;
+    local.maxPayloadBytes = (std::uint16_t)std::min<std::size_t>(bufferSize_, 0xFFFF);
+    local.maxChannels = (std::uint16_t)std::min<std::size_t>(maxChannels_, 0xFFFF);
+
+    UdpCapabilities chosen = UdpCapabilities::choose(offer, local, hostLittle_);
+    if (auth_) {
+        // answered by a SESSION that restarts this sender's replay window
+        ReplaySource& rs = replaySource(from, clockNanos());
+        rs.challenge = challengeRng_() | 1;
+        chosen.challenge = rs.challenge;
+    }
+
+    std::uint8_t ack[UdpCapabilities::MESSAGE_BYTES + UdpAuth::TAG_BYTES];
+    UdpCapabilities::encode(ack, UdpCapabilities::MAGIC_ACK, nonce, chosen);
+    sendReply(ack, UdpCapabilities::MESSAGE_BYTES, from);
+
+    char ip[INET_ADDRSTRLEN] = {0};
+    inet_ntop(AF_INET, &from.sin_addr, ip, sizeof(ip));
+    std::cout << "Handshake with " << ip << ":" << ntohs(from.sin_port)
+              << " -> version=" << int(chosen.chosenVersion)
+              << " order=" << UdpCapabilities::orderName(chosen.chosenOrder)
+              << " sparse=" << ((chosen.chosenCompression & UdpCapabilities::COMP_SPARSE) ? "yes" : "no")
+              << " preview=" << ((chosen.chosenCompression & UdpCapabilities::COMP_PREVIEW) ? "yes" : "no")
+              << " applyAt=" << ((chosen.chosenCompression & UdpCapabilities::COMP_APPLY_AT) ? "yes" : "no")
+              << " maxChannels=" << chosen.maxChannels
+              << " maxPayload=" << chosen.maxPayloadBytes << "\n";
+}
+
+void UdpDoubleReceiver::startSession(const std::uint8_t* p, std::size_t received, const sockaddr_in& from) {
+    std::uint64_t timestamp = 0, challenge = 0;
+    if (!UdpAuth::decodeSession(p, received, timestamp, challenge)) return;
+
+    auto it = replaySources_.find(sourceKey(ntohl(from.sin_addr.s_addr), ntohs(from.sin_port)));
+    if (it == replaySources_.end() || it->second.challenge == 0 || it->second.challenge != challenge)
+        return;   // not ours, already answered, or a replayed SESSION
+    it->second.challenge = 0;
+    it->second.window.restart(timestamp);
+    it->second.restarted = true;
+    it->second.bulkFloor = timestamp;
+}
+
+UdpDoubleReceiver::ReplaySource& UdpDoubleReceiver::replaySource(const sockaddr_in& from, std::int64_t now) {
+    const std::uint64_t key = sourceKey(ntohl(from.sin_addr.s_addr), ntohs(from.sin_port));
+    auto it = replaySources_.find(key);
+    if (it == replaySources_.end()) {
+        if (replaySources_.size() >= MAX_REPLAY_SOURCES) {
+            replaySources_.erase(std::min_element(replaySources_.begin(), replaySources_.end(),
+                [](const auto& a, const auto& b) { return a.second.lastSeen < b.second.lastSeen; }));
+        }
+        it = replaySources_.emplace(key, ReplaySource()).first;
+    }
+    it->second.lastSeen = now;
+    return it->second;
+}
+
 void UdpDoubleReceiver::run() {
+    bool waiting = false;   // between a WOULDBLOCK and the next datagram
     while (running_) {
+        if (!held_.empty()) releaseDue();
+
+        const bool pollReorder = anyReorder_.load(std::memory_order_relaxed);
+        if (reportIntervalNanos_ > 0 || pollReorder) {
+            const std::int64_t now = clockNanos();
+            if (reportIntervalNanos_ > 0 && now >= nextReportNanos_) sendReports(now);
+            if (pollReorder) {
+                const std::size_t n = streamCount_.load(std::memory_order_relaxed);
+                for (std::size_t id = 0; id < n; ++id)
+                    if (ReorderBuffer* rb = streams_[id]->reorder.load(std::memory_order_acquire)) rb->poll(now);
+            }
+        }
+
         sockaddr_in from{};
-        int fromLen = sizeof(from);
-
-        int received = recvfrom(
-            sockfd_,
-            (char*)recvBuffer_.data(),
-            (int)recvBuffer_.size(),
-            0,
-            (sockaddr*)&from,
-            &fromLen
-        );
-
-        if (!running_) break;
-
-        if (received == SOCKET_ERROR) {
-            int err = WSAGetLastError();
-            if (err == WSAEWOULDBLOCK) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+        Slot& slot = *spare_;
+        std::uint8_t* p = slot.wire();
+
+        int received;
+        if (io_) {
+            // simulate(): io's datagrams and clock
+            received = io_->receive(p, bufferSize_, from);
+            if (received < 0) break;   // source exhausted
+            if (received == 0) {
+                io_->waitReadable(idleDeadline());
                 continue;
             }
-            std::cerr << "recvfrom() error: " << err << "\n";
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            continue;
+        } else {
+            int fromLen = sizeof(from);
+            received = recvfrom(
+                sockfd_,
+                (char*)p,
+                (int)bufferSize_,
+                0,
+                (sockaddr*)&from,
+                &fromLen
+            );
+
+            if (!running_) break;
+
+            if (received == SOCKET_ERROR) {
+                int err = WSAGetLastError();
+                if (err == WSAEWOULDBLOCK) {
+                    if (!waiting) {
+                        wait_->begin();
+                        waiting = true;
+                    }
+                    wait_->idle([this](std::int64_t until) { waitReadable(until); }, idleDeadline());
+                    continue;
+                }
+                if (err == WSAEMSGSIZE) {
+                    // larger than bufferSize (e.g. a path MTU probe): dropped
+                    oversizeDropped_.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                std::cerr << "recvfrom() error: " << err << "\n";
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            if (waiting) {
+                wait_->done();
+                waiting = false;
+            }
+        }
+
+        if (recorder_) recorder_->append(clockNanos(), from, p, (std::size_t)received);
+
+        // forged / corrupted datagrams never reach the parser
+        if (auth_) {
+            if (!auth_->verify(p, (std::size_t)received)) {
+                authRejected_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            received -= (int)UdpAuth::TAG_BYTES;
         }
 
         if (received < (int)HEADER_BYTES) {
-            continue; // too small
+            continue; // too small (slot is simply reused)
         }
 
-        const std::uint8_t* p = recvBuffer_.data();
+        const std::int64_t arrival = clockNanos();
+
+        // Byte order is detected from the magic; handshakes are always BE.
+        Endian e;
+        const std::uint32_t magicBE = read32(p, Endian::Big);
+        const std::uint32_t magicLE = read32(p, Endian::Little);
+        auto isFrame = [](std::uint32_t m) {
+            return m == MAGIC_UDPD || m == MAGIC_UDPS || m == MAGIC_UDPT || m == MAGIC_UDPE;
+        };
+        if (isFrame(magicBE)) {
+            e = Endian::Big;
+        } else if (isFrame(magicLE)) {
+            e = Endian::Little;
+        } else {
+            if (!sourceAllowed(ntohl(from.sin_addr.s_addr), ntohs(from.sin_port))) {
+                rejectedPackets_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (magicBE == UdpCapabilities::MAGIC_HELLO) answerHello(p, (std::size_t)received, from);
+            else if (magicBE == UdpClock::MAGIC_SYNC) answerClock(p, (std::size_t)received, from, arrival);
+            else if (magicBE == UdpAuth::MAGIC_SESSION && auth_) startSession(p, (std::size_t)received, from);
+            else if (magicBE == UdpBulk::MAGIC_CHUNK && bulkMaxDoubles_) handleBulkChunk(p, (std::size_t)received, from, arrival);
+            continue;
+        }
 
-        // Header is always in the sender-selected endian too.
-        std::uint32_t magic = read32(p + 0, endian_);
-        std::uint16_t ver   = read16(p + 4, endian_);
-        std::uint16_t count = read16(p + 6, endian_);
-        std::uint32_t seq   = read32(p + 8, endian_);
-        std::uint64_t ts    = read64(p + 12, endian_);
+        std::uint32_t magic = read32(p + 0, e);
+        std::uint16_t ver   = read16(p + 4, e);
+        std::uint16_t count = read16(p + 6, e);
+        std::uint32_t seq   = read32(p + 8, e);
+        std::uint64_t ts    = read64(p + 12, e);
 
-        if (magic != MAGIC_UDPD) continue;
         if (ver != VERSION_1) continue;
+        if (!sourceAllowed(ntohl(from.sin_addr.s_addr), ntohs(from.sin_port))) {
+            rejectedPackets_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        // a truncated frame must not take a stream, move seq or the window
+        if (!frameComplete(magic, p, (std::size_t)received, count, e)) continue;
+        ReplaySource* rs = nullptr;
+        if (auth_) {
+            rs = &replaySource(from, arrival);
+            if (!rs->window.accept(seq, ts)) {
+                replayRejected_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+        }
 
-        std::size_t expectedBytes = HEADER_BYTES + (std::size_t(count) * 8);
-        if (expectedBytes > (std::size_t)received) {
-            continue; // truncated packet
+        // only valid frames register a sender; junk and control traffic
+        // never take a stream
+        Stream* sp = streamFor(from);
+        if (!sp) continue;  // cap reached / not allowed
+        Stream& st = *sp;
+        if (rs && rs->restarted) {
+            // first frame of a new session: the sender's seq starts over
+            st.haveSeq = false;
+            rs->restarted = false;
+        }
+        const bool newer = trackSeq(st, seq, ts, arrival);
+        if (rs && !newer) {
+            // the window is per address:port, so an old frame replayed
+            // from another port passes it but must not roll the stream back
+            replayRejected_.fetch_add(1, std::memory_order_relaxed);
+            continue;
         }
 
-        Packet pkt;
-        pkt.seq = seq;
-        pkt.timestampNanos = ts;
-        pkt.data.resize(count);
+        const bool native = (e == Endian::Little) == hostLittle_;
+        slot.endian = e;
 
-        const std::uint8_t* dptr = p + HEADER_BYTES;
-        for (std::size_t i = 0; i < count; ++i) {
-            pkt.data[i] = readDouble(dptr + i * 8, endian_);
+        slot.horizon = 0;
+        std::int64_t applyAt = 0;
+        if (magic == MAGIC_UDPS) {
+            // a late update would overwrite newer state until the next refresh
+            if (!newer) continue;
+            if (!mergeSparse(st, slot, p, count)) continue;
+        } else {
+            const std::size_t payloadEnd = HEADER_BYTES + (std::size_t(count) * 8);
+            if (magic == MAGIC_UDPT) {
+                // preview stays in wire form; getSetpointAt() decodes it
+                slot.horizon = read16(p + payloadEnd, e);
+            } else if (magic == MAGIC_UDPE) {
+                applyAt = (std::int64_t)read64(p + payloadEnd, e);
+            }
+            slot.allDecoded = native;
+
+            if (newer) {
+                // Full frame is the new base for sparse updates, so the
+                // first UDPS after it merges straight away.
+                if (native) {
+                    std::memcpy(st.state.data(), p + HEADER_BYTES, std::size_t(count) * 8);
+                } else {
+                    for (std::size_t i = 0; i < count; ++i)
+                        st.state[i] = readDouble(p + HEADER_BYTES + i * 8, e);
+                }
+                st.stateCount = count;
+                st.stateValid = true;
+            }
+
+            // Decode subscribed channels in place; the rest stay in wire form
+            // and are decoded on access. Native-endian payloads need nothing.
+            if (!native) {
+                std::uint64_t* decoded = slot.decodedMask.data();
+                if (anySubscribed_.load(std::memory_order_acquire)) {
+                    for (std::size_t w = 0; w < maskWords_; ++w) {
+                        std::uint64_t bits = subMask_[w].load(std::memory_order_relaxed);
+                        if (w * 64 + 64 > count) {
+                            const std::size_t valid = (count > w * 64) ? count - w * 64 : 0;
+                            bits &= (valid >= 64) ? ~std::uint64_t(0) : ((std::uint64_t(1) << valid) - 1);
+                        }
+                        decoded[w] = bits;
+                        while (bits) {
+                            const std::size_t i = w * 64 + ctz64(bits);
+                            swapDoublesInPlace(p + HEADER_BYTES + i * 8, 1);
+                            bits &= bits - 1;
+                        }
+                    }
+                } else {
+                    for (std::size_t w = 0; w < maskWords_; ++w) decoded[w] = 0;
+                }
+            }
         }
 
-        {
-            std::lock_guard<std::mutex> lock(dataMutex_);
-            latest_ = std::move(pkt);
-            hasData_ = true;
+        slot.seq = seq;
+        slot.timestampNanos = ts;
+        slot.arrivalNanos = arrival;
+        slot.applyAtNanos = applyAt;
+        slot.count = count;
+
+        if (magic == MAGIC_UDPE && holdFrame(st, applyAt, arrival)) continue;
+        publish(st, spare_);
+    }
+}
+
+void UdpDoubleReceiver::publish(Stream& st, Slot*& filled) {
+    Slot& slot = *filled;
+    const std::size_t count = slot.count;
+
+    TimeSeriesStore* store = st.store.load(std::memory_order_acquire);
+    FramePipeline* pipeline = st.pipeline.load(std::memory_order_acquire);
+    ReorderBuffer* reorder = st.reorder.load(std::memory_order_acquire);
+    TriggerEngine* triggers = st.triggers.load(std::memory_order_acquire);
+    if (store || pipeline || reorder || triggers) {
+        const double* row = slot.values();
+        if (!slot.allDecoded) {
+            for (std::size_t i = 0; i < count; ++i) storeRow_[i] = decodeChannel(slot, i);
+            row = storeRow_.data();
         }
+        if (store) store->append(slot.arrivalNanos, row, count);
+        if (pipeline) pipeline->submit(st.id, slot.seq, slot.timestampNanos, slot.arrivalNanos, row, count);
+        if (reorder) reorder->push(slot.seq, slot.timestampNanos, slot.arrivalNanos, row, count);
+        if (triggers) triggers->evaluate(slot.seq, slot.timestampNanos, slot.arrivalNanos, row, count);
+    }
+
+    st.received.fetch_add(1, std::memory_order_relaxed);
+    st.lastArrival.store(slot.arrivalNanos, std::memory_order_relaxed);
+
+    // Publish: the filled slot becomes the stream's back slot and is
+    // handed to readers; the old back slot is the next recv target.
+    std::swap(st.slots[st.backIndex], filled);
+    const int prev = st.middle.exchange(st.backIndex | SLOT_FRESH, std::memory_order_acq_rel);
+    if (prev & SLOT_FRESH) st.overwritten.fetch_add(1, std::memory_order_relaxed);
+    st.backIndex = prev & SLOT_MASK;
+    st.hasData.store(true, std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);   // pairs with waitLatest(): publish vs. blockedReaders_
+    if (blockedReaders_.load(std::memory_order_relaxed) > 0) wakeReaders();
+}
+
+// ---------- apply-at release queue ----------
+void UdpDoubleReceiver::setReleaseQueue(std::size_t maxHeld, std::int64_t maxHoldNanos, std::int64_t spinNanos) {
+    maxHeld_ = std::max<std::size_t>(1, maxHeld);
+    maxHoldNanos_ = std::max<std::int64_t>(0, maxHoldNanos);
+    releaseSpinNanos_ = std::max<std::int64_t>(0, spinNanos);
+    held_.reserve(maxHeld_);
+}
+
+UdpDoubleReceiver::ReleaseStats UdpDoubleReceiver::getReleaseStats() const {
+    std::lock_guard<std::mutex> lock(releaseMutex_);
+    ReleaseStats r = releaseStats_;
+    if (r.released) {
+        r.meanErrorNanos = releaseErrorSum_ / (double)r.released;
+        r.meanAbsErrorNanos = releaseAbsErrorSum_ / (double)r.released;
+    }
+    return r;
+}
+
+bool UdpDoubleReceiver::heldLater(const Held& a, const Held& b) {
+    return a.applyAt != b.applyAt ? a.applyAt > b.applyAt : a.order > b.order;
+}
+
+bool UdpDoubleReceiver::holdFrame(Stream& st, std::int64_t applyAt, std::int64_t arrival) {
+    std::lock_guard<std::mutex> lock(releaseMutex_);   // stats only
+    if (applyAt <= arrival) {
+        ++releaseStats_.lateOnArrival;
+        return false;
+    }
+    if (applyAt - arrival > maxHoldNanos_) {
+        ++releaseStats_.tooFar;
+        return false;
+    }
+    if (held_.size() >= maxHeld_) {
+        ++releaseStats_.queueFull;
+        return false;
+    }
+
+    // the filled spare slot waits in the queue; recv goes to another one
+    Slot* next;
+    if (!freeSlots_.empty()) {
+        next = freeSlots_.back();
+        freeSlots_.pop_back();
+    } else {
+        next = newSlot();
+    }
+    held_.push_back(Held{applyAt, heldOrder_++, &st, spare_});
+    std::push_heap(held_.begin(), held_.end(), heldLater);
+    spare_ = next;
+    releaseStats_.held = held_.size();
+    return true;
+}
+
+void UdpDoubleReceiver::releaseDue() {
+    // Spins at most one slice per call; the run loop reads the socket in
+    // between and comes back, so a held frame never stalls other traffic.
+    const std::int64_t sliceEnd = clockNanos() + RELEASE_SLICE_NANOS;
+    while (!held_.empty()) {
+        const std::int64_t due = held_.front().applyAt;
+        if (due - clockNanos() > releaseSpinNanos_) return;
+        const std::int64_t until = std::min<std::int64_t>(due, sliceEnd);
+        if (io_) io_->sleepUntil(until);
+        else while (nowNanos() < until) std::this_thread::yield();
+        if (until < due) return;
+
+        std::pop_heap(held_.begin(), held_.end(), heldLater);
+        Held h = held_.back();
+        held_.pop_back();
+        publish(*h.stream, h.slot);
+        const std::int64_t error = clockNanos() - due;   // once visible to readers
+        freeSlots_.push_back(h.slot);
+
+        std::lock_guard<std::mutex> lock(releaseMutex_);
+        ++releaseStats_.released;
+        releaseStats_.held = held_.size();
+        releaseErrorSum_ += (double)error;
+        releaseAbsErrorSum_ += (double)(error < 0 ? -error : error);
+        if (error > releaseStats_.maxLateNanos) releaseStats_.maxLateNanos = error;
+        if (-error > releaseStats_.maxEarlyNanos) releaseStats_.maxEarlyNanos = -error;
     }
 }
+
+void UdpDoubleReceiver::answerClock(const std::uint8_t* p, std::size_t received, const sockaddr_in& from,
+                                    std::int64_t receivedNanos) {
+    UdpClock c;
+    if (!UdpClock::decode(p, received, UdpClock::MAGIC_SYNC, c)) return;
+    c.receiveNanos = receivedNanos;
+    c.replyNanos = clockNanos();
+
+    std::uint8_t msg[UdpClock::MESSAGE_BYTES + UdpAuth::TAG_BYTES];
+    UdpClock::encode(msg, UdpClock::MAGIC_REPLY, c);
+    sendReply(msg, UdpClock::MESSAGE_BYTES, from);
+}
+
+// ---------- authentication ----------
+void UdpDoubleReceiver::enableAuth(const std::uint8_t* key) {
+    if (running_) return;
+    auth_.reset(key ? new UdpAuth(key) : nullptr);
+    replaySources_.clear();
+    challengeRng_.seed(((std::uint64_t)std::random_device()() << 32) ^ (std::uint64_t)nowNanos());
+}
+
+void UdpDoubleReceiver::sendReply(std::uint8_t* msg, std::size_t n, const sockaddr_in& to) {
+    if (auth_) {
+        auth_->sign(msg, n);
+        n += UdpAuth::TAG_BYTES;
+    }
+    if (io_) io_->send(msg, n, to);
+    else sendto(sockfd_, (const char*)msg, (int)n, 0, (const sockaddr*)&to, (int)sizeof(to));
+}
+
+// ---------- simulation ----------
+bool UdpDoubleReceiver::simulate(ReceiverIo& io) {
+    if (running_) return false;
+    io_ = &io;
+    running_ = true;
+    run();
+    running_ = false;
+    io_ = nullptr;
+    return true;
+}
+
+void UdpDoubleReceiver::setTraceRecorder(TraceWriter* writer) {
+    recorder_ = writer;
+}
+
+std::int64_t UdpDoubleReceiver::clockNanos() const {
+    return io_ ? io_->now() : nowNanos();
+}
+
+// ---------- waiting ----------
+void UdpDoubleReceiver::setWaitStrategy(const WaitStrategy::Config& cfg) {
+    if (running_) return;
+    wait_.reset(new WaitStrategy(cfg));
+}
+
+std::int64_t UdpDoubleReceiver::idleDeadline() const {
+    // bounded so stop() is noticed even if nothing arrives
+    const std::int64_t now = clockNanos();
+    std::int64_t until = now + MAX_IDLE_NANOS;
+    if (anyReorder_.load(std::memory_order_relaxed)) until = std::min<std::int64_t>(until, now + REORDER_POLL_NANOS);
+    if (reportIntervalNanos_ > 0) until = std::min<std::int64_t>(until, nextReportNanos_);
+    if (!held_.empty()) until = std::min<std::int64_t>(until, held_.front().applyAt - releaseSpinNanos_);
+    return until;
+}
+
+void UdpDoubleReceiver::waitReadable(std::int64_t untilNanos) {
+    const std::int64_t left = untilNanos - nowNanos();
+    const SOCKET s = sockfd_;
+    if (left <= 0 || s == INVALID_SOCKET || !running_) return;
+
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(s, &readable);
+    timeval tv;
+    tv.tv_sec = (long)(left / 1'000'000'000);
+    tv.tv_usec = (long)((left % 1'000'000'000) / 1000);
+    select((int)s + 1, &readable, nullptr, nullptr, &tv);   // nfds is ignored on Windows
+}
+
+void UdpDoubleReceiver::wakeReaders() {
+    std::lock_guard<std::mutex> lock(publishMutex_);
+    publishCv_.notify_all();
+}
+
+bool UdpDoubleReceiver::waitLatest(int source, Packet& out, WaitStrategy& wait, std::int64_t timeoutNanos) {
+    auto fresh = [&] {
+        if (source < 0 || (std::size_t)source >= streamCount_.load(std::memory_order_acquire)) return false;
+        return (streams_[source]->middle.load(std::memory_order_acquire) & SLOT_FRESH) != 0;
+    };
+    auto block = [&](std::int64_t until) {
+        std::unique_lock<std::mutex> lock(publishMutex_);
+        blockedReaders_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t left = until - nowNanos();
+        if (!fresh() && left > 0) publishCv_.wait_for(lock, std::chrono::nanoseconds(left));
+        blockedReaders_.fetch_sub(1, std::memory_order_relaxed);
+    };
+
+    if (!wait.wait(fresh, block, nowNanos() + timeoutNanos)) return false;
+    return getLatest(source, out);
+}
@@ -6,11 +6,27 @@
 #include <mutex>
 #include <atomic>
 #include <cstdint>
+#include <map>
+#include <memory>
+#include <deque>
+#include <condition_variable>
+#include <random>
+
+#include "UdpAuth.hpp"
+#include "WaitStrategy.hpp"
+#include "SteadyClock.hpp"
 
 #define WIN32_LEAN_AND_MEAN
 #include <winsock2.h>
 #include <ws2tcpip.h>
 
+class TimeSeriesStore;
+class FramePipeline;
+class ReorderBuffer;
+class TriggerEngine;
+class ReceiverIo;
+class TraceWriter;
+
 class UdpDoubleReceiver {
 public:
     enum class Endian {
@@ -21,10 +37,53 @@ public:
     struct Packet {
         std::uint32_t seq = 0;
         std::uint64_t timestampNanos = 0;
+        std::int64_t  arrivalNanos = 0;   // local steady_clock time recvfrom() returned
+        std::int64_t  applyAtNanos = 0;   // apply-at frames: local due time, else 0
+        std::vector<double> data;
+    };
+
+    // Setpoint of a stream at some local time (see getSetpointAt).
+    struct Setpoint {
+        std::uint32_t seq = 0;               // frame it comes from
+        std::int64_t  anchorNanos = 0;       // that frame's arrival: current setpoint
+        std::int64_t  horizonNanos = 0;      // its last planned setpoint (anchor without preview)
+        bool fromPreview = false;            // interpolated along the frame's preview
+        bool beyondHorizon = false;          // after horizonNanos: last setpoint held
         std::vector<double> data;
     };
 
+    // Apply-at release queue (see setReleaseQueue).
+    struct ReleaseStats {
+        std::uint64_t released = 0;          // published by the queue
+        std::uint64_t lateOnArrival = 0;     // already due when received
+        std::uint64_t tooFar = 0;            // beyond maxHoldNanos: published at once
+        std::uint64_t queueFull = 0;         // no room: published at once
+        std::size_t   held = 0;              // waiting now
+        double meanErrorNanos = 0.0;         // publish - apply time of released frames (> 0: late)
+        double meanAbsErrorNanos = 0.0;
+        std::int64_t maxEarlyNanos = 0;
+        std::int64_t maxLateNanos = 0;
+    };
+
+    // One sender endpoint seen by a demultiplexing receiver.
+    struct SourceInfo {
+        int id = -1;
+        std::string address;                 // "ip:port"
+        std::uint64_t received = 0;          // accepted frames
+        std::uint64_t lost = 0;              // gaps in seq
+        std::uint64_t lateOrDuplicate = 0;   // seq not newer than the last one
+        std::uint32_t lastSeq = 0;
+        std::int64_t  lastArrivalNanos = 0;
+        std::int64_t  jitterNanos = 0;       // interarrival jitter (RFC 3550)
+        std::uint64_t overwritten = 0;       // published but never read
+    };
+
+    class FrameView;
+
     // host: "0.0.0.0" recommended (bind all interfaces)
+    // endian: nominal wire order. Frames are accepted in either order
+    // (detected from the magic) and HELLO handshakes are answered with the
+    // host's native order when the sender supports it.
     UdpDoubleReceiver(const std::string& host,
                       int port,
                       std::size_t bufferSize = 2048,
@@ -36,12 +95,155 @@ public:
     void stop();
 
     // Copies latest packet into out. Returns false if nothing received yet.
+    // With source demux enabled this is the first registered sender.
     bool getLatest(Packet& out);
 
+    // Latest frame in wire form; channels are decoded on access. The view
+    // holds the reader lock, so keep it short-lived. Returns false if
+    // nothing received yet.
+    bool getLatestView(FrameView& out);
+
+    // Per-source streams (call before start()). Each sender endpoint
+    // (address:port) gets its own latest frame, seq tracking and stats.
+    // New senders register on their first valid frame (magic, version and,
+    // with auth, tag checked) up to maxSources; packets from any further or
+    // disallowed sender are dropped and counted.
+    bool enableSourceDemux(std::size_t maxSources);
+    // Once any entry exists only listed senders get through, with or
+    // without source demux. port 0 matches every port of ip. Call before
+    // start().
+    bool allowSource(const std::string& ip, std::uint16_t port = 0);
+
+    // Stream id of a sender, -1 if it has not registered. Without source
+    // demux the whole port is stream 0.
+    int  findSource(const std::string& ip, std::uint16_t port) const;
+    bool getLatest(int source, Packet& out);
+    bool getLatestView(int source, FrameView& out);
+    std::vector<SourceInfo> getSources() const;
+    std::uint64_t getRejectedPackets() const { return rejectedPackets_.load(std::memory_order_relaxed); }
+    // Datagrams larger than bufferSize, dropped unread.
+    std::uint64_t getOversizeDropped() const { return oversizeDropped_.load(std::memory_order_relaxed); }
+
+    // Setpoint at local steady_clock time tNanos from the newest frame of a
+    // stream. Trajectory preview frames ("UDPT", see
+    // UdpDoubleSender::sendPreviewWithSeq) place planned setpoint k at
+    // arrival + offset k; between them the setpoint is interpolated
+    // linearly, so lost frames are bridged by the previous frame's plan.
+    // Before arrival, and for frames without preview, the current setpoint;
+    // after the last planned one, that one. False if nothing received yet.
+    bool getSetpointAt(int source, std::int64_t tNanos, Setpoint& out);
+    bool getSetpointAt(std::int64_t tNanos, Setpoint& out) { return getSetpointAt(0, tNanos, out); }
+
+    // Channels the receiver thread decodes eagerly. With no subscriptions
+    // the receiver only validates headers. Returns an id for unsubscribe.
+    int  subscribeChannels(const std::vector<std::uint16_t>& channels);
+    void unsubscribeChannels(int id);
+
+    // Appends every frame of a stream (arrival time, all channels) to store;
+    // nullptr detaches. The store must outlive the attachment.
+    bool attachStore(TimeSeriesStore* store, int source = 0);
+
+    // Submits every frame of a stream (decoded) to a worker pipeline, tagged
+    // with the stream id; nullptr detaches. Frames the pipeline cannot take
+    // are dropped there, never stalling the receiver.
+    bool attachPipeline(FramePipeline* pipeline, int source = 0);
+
+    // Feeds every frame of a stream (decoded) through a reorder window that
+    // delivers in seq order on the receiver thread; its gap timeouts are
+    // polled from the receive loop. nullptr detaches.
+    bool attachReorder(ReorderBuffer* reorder, int source = 0);
+
+    // Evaluates a stream's trigger rules (TriggerEngine.hpp) on every frame
+    // as it is published, in arrival order, on the receiver thread; nullptr
+    // detaches. Add the rules before attaching.
+    bool attachTriggers(TriggerEngine* triggers, int source = 0);
+
+    // Sends a receiver report (UdpReport.hpp: highest seq, loss, jitter,
+    // queue pressure) to every active sender each intervalMs; <= 0: off.
+    // Call before start().
+    void enableReports(int intervalMs);
+
+    // Bulk transfers from a BulkSender (UdpBulk.hpp): chunks are
+    // reassembled, selectively acknowledged and CRC-checked on completion.
+    // maxDoubles bounds one transfer, 0 disables. One transfer is assembled
+    // at a time: chunks of other transfers go unanswered (their sender
+    // retries) until it completes, its sender starts a newer one, or it has
+    // been idle for 2 s. Call before start().
+    void enableBulk(std::size_t maxDoubles);
+    // Oldest completed transfer; false if none is waiting.
+    bool takeBulk(std::vector<double>& out, std::uint32_t* transferId = nullptr);
+
+    // Per-datagram authentication (UdpAuth.hpp) with a 16-byte key shared
+    // with the senders; nullptr turns it off. Datagrams without a valid tag
+    // are dropped before any parsing, frames must also pass a replay window
+    // on seq kept per sender address:port (with or without source demux),
+    // and replies (handshake, reports, bulk ACKs) are tagged. Each ACK
+    // carries a fresh session challenge; the sender's SESSION answer
+    // restarts its window (and its stream's seq), so a rebooted sender is
+    // not locked out. A frame that is not newer than its stream's last one
+    // is dropped as a replay too, so a frame replayed from a new port cannot
+    // roll a stream back. The address itself is not authenticated: with
+    // source demux such a replay opens a stream of its own, and right after
+    // a session restart an old-session frame may still be newer; allowSource()
+    // with the sender's port closes both. Bulk chunks must be stamped after
+    // the sender's last completed transfer. Call before start().
+    void enableAuth(const std::uint8_t* key);
+    std::uint64_t getAuthRejected() const { return authRejected_.load(std::memory_order_relaxed); }
+    std::uint64_t getReplayRejected() const { return replayRejected_.load(std::memory_order_relaxed); }
+
+    // Apply-at frames ("UDPE", see UdpDoubleSender::sendApplyAtWithSeq)
+    // carry the instant they take effect on this receiver's steady_clock.
+    // They wait in a time-ordered queue of up to maxHeld frames and are
+    // published (latest frame, stores, pipeline, reorder) at that instant:
+    // the receiver thread idles until spinNanos before it and spins the
+    // rest in short slices, reading the socket in between. Frames already
+    // due, more than maxHoldNanos ahead or finding the queue full are
+    // published on arrival. Clock sync requests ("UDPC") are always
+    // answered. Call before start().
+    void setReleaseQueue(std::size_t maxHeld, std::int64_t maxHoldNanos, std::int64_t spinNanos);
+    ReleaseStats getReleaseStats() const;
+
+    // Runs the receive loop on the calling thread against io (ReceiverIo.hpp)
+    // instead of the socket, until io is exhausted. Everything the receiver
+    // thread does (seq tracking, sparse merge, reorder, release queue,
+    // reports, stores) then runs on io's clock: a trace on a virtual clock
+    // (SimulatedIo, ReceiverSimulation.hpp) replays as fast as it decodes
+    // and gives identical results every run. False while start()ed.
+    bool simulate(ReceiverIo& io);
+
+    // Appends every received datagram (arrival time, sender, raw bytes) to
+    // writer for later simulate() runs; nullptr stops. Call before start().
+    void setTraceRecorder(TraceWriter* writer);
+
+    // How the receiver thread waits for datagrams (WaitStrategy.hpp).
+    // Default: poll every 2 ms. Block sleeps in select() on the socket.
+    // Call before start().
+    void setWaitStrategy(const WaitStrategy::Config& cfg);
+    WaitStrategy::Stats getWaitStats() const { return wait_->stats(); }
+
+    // Waits for a frame of source published since the last read, then
+    // copies it like getLatest. False on timeout. Each consumer thread
+    // passes its own WaitStrategy; with Block it sleeps until the receiver
+    // publishes.
+    bool waitLatest(int source, Packet& out, WaitStrategy& wait, std::int64_t timeoutNanos);
+    bool waitLatest(Packet& out, WaitStrategy& wait, std::int64_t timeoutNanos) {
+        return waitLatest(0, out, wait, timeoutNanos);
+    }
+
     bool isRunning() const { return running_.load(); }
 
 private:
     void run();
+    // Receiver idle: until the socket is readable or untilNanos.
+    void waitReadable(std::int64_t untilNanos);
+    // Next instant the run loop has housekeeping (reports, reorder
+    // timeouts, held frames).
+    std::int64_t idleDeadline() const;
+    void wakeReaders();
+    static std::int64_t nowNanos() { return SteadyClock::nowNanos(); }
+    // Receiver thread time: io_'s clock under simulate(), else nowNanos().
+    std::int64_t clockNanos() const;
+    void rebuildSubscriptionMask();   // requires subMutex_
 
     // Endian-aware readers
     static std::uint16_t read16(const std::uint8_t* p, Endian e);
@@ -49,6 +251,11 @@ private:
     static std::uint64_t read64(const std::uint8_t* p, Endian e);
     static double readDouble(const std::uint8_t* p, Endian e);
 
+    static bool hostIsLittleEndian();
+    // Converts count wire doubles at p to host order in place.
+    static void swapDoublesInPlace(std::uint8_t* p, std::size_t count);
+    static unsigned ctz64(std::uint64_t v);   // v != 0
+
 private:
     std::string host_;
     int port_;
@@ -57,13 +264,278 @@ private:
 
     std::atomic<bool> running_;
     std::thread receiverThread_;
+    ReceiverIo* io_ = nullptr;            // simulate() only
+    TraceWriter* recorder_ = nullptr;
 
     SOCKET sockfd_;
     bool wsaInitialized_ = false;
 
-    std::vector<std::uint8_t> recvBuffer_;
+    // Frame slots (see Stream): the receiver recv()s straight into a slot,
+    // swaps/validates in place and publishes it without copying.
+    // Wire bytes start at WIRE_OFFSET so the payload (after the 20-byte
+    // header) lands 8-byte aligned and can be read as double[] directly.
+    static constexpr std::size_t WIRE_OFFSET = 4;
+    static constexpr int SLOT_FRESH = 4;     // bit in Stream::middle: unread publish
+    static constexpr int SLOT_MASK  = 3;
 
-    std::mutex dataMutex_;
-    Packet latest_;
-    bool hasData_ = false;
+    struct Slot {
+        std::vector<double> storage;        // 8-byte aligned backing store
+        std::uint32_t seq = 0;
+        std::uint64_t timestampNanos = 0;
+        std::int64_t  arrivalNanos = 0;
+        std::int64_t  applyAtNanos = 0;
+        std::uint16_t count = 0;
+        std::uint16_t horizon = 0;               // planned setpoints after the payload (UDPT)
+        Endian endian = Endian::Big;             // wire order of this frame
+        bool allDecoded = false;                 // every channel is host order
+        std::vector<std::uint64_t> decodedMask;  // else: bit set = host order
+
+        bool isDecoded(std::size_t i) const { return allDecoded || ((decodedMask[i >> 6] >> (i & 63)) & 1u); }
+        std::uint8_t* wire() { return reinterpret_cast<std::uint8_t*>(storage.data()) + WIRE_OFFSET; }
+        const std::uint8_t* wire() const { return reinterpret_cast<const std::uint8_t*>(storage.data()) + WIRE_OFFSET; }
+        double* values() { return storage.data() + (WIRE_OFFSET + 20) / 8; }
+        const double* values() const { return storage.data() + (WIRE_OFFSET + 20) / 8; }
+    };
+    double decodeChannel(const Slot& s, std::size_t i) const;
+
+    // Per-sender state. Triple buffer: the receiver recv()s into spare_,
+    // and once the packet is accepted swaps it into slots[backIndex] and
+    // publishes by exchanging indices with middle. Readers take the fresh
+    // middle slot into frontIndex.
+    struct Stream {
+        int id = 0;
+        Slot* slots[3] = {nullptr, nullptr, nullptr};
+        int backIndex = 0;                  // receiver thread only
+        std::atomic<int> middle{1};
+        int frontIndex = 2;                 // guarded by readMutex
+        std::mutex readMutex;               // serialises readers; never taken by run()
+        std::atomic<bool> hasData{false};
+
+        // Current channel state for merging sparse ("UDPS") updates;
+        // receiver thread only. Valid once a full frame has been seen.
+        std::vector<double> state;
+        std::size_t stateCount = 0;
+        bool stateValid = false;
+
+        // seq tracking; the receiver writes, getSources() reads
+        bool haveSeq = false;
+        std::uint32_t lastSeq = 0;
+        std::int64_t lastTransit = 0;           // arrival - sender timestamp
+        std::uint32_t reportedReceived = 0;     // received at the last report
+        std::atomic<std::uint64_t> source{0};   // sourceKey() of the sender
+        std::atomic<std::uint64_t> received{0};
+        std::atomic<std::uint64_t> lost{0};
+        std::atomic<std::uint64_t> lateOrDup{0};
+        std::atomic<std::uint32_t> lastSeqSeen{0};
+        std::atomic<std::int64_t>  lastArrival{0};
+        std::atomic<std::int64_t>  jitter{0};
+        std::atomic<std::uint64_t> overwritten{0};
+
+        std::atomic<TimeSeriesStore*> store{nullptr};
+        std::atomic<FramePipeline*> pipeline{nullptr};
+        std::atomic<ReorderBuffer*> reorder{nullptr};
+        std::atomic<TriggerEngine*> triggers{nullptr};
+    };
+
+    // Open-addressing table entry; key 0 = empty, stream -1 = rejected.
+    // Only the receiver thread inserts (stream first, then key with
+    // release), entries are never removed.
+    struct SourceEntry {
+        std::atomic<std::uint64_t> key{0};
+        std::atomic<std::int32_t>  stream{-1};
+    };
+
+    // Replay state per sourceKey(), receiver thread only. challenge: issued
+    // in the last ACK to that sender, 0 once answered. restarted: a SESSION
+    // was accepted, the next frame resets the stream's seq tracking.
+    // bulkFloor: bulk chunks must be stamped later (session start, then
+    // the newest chunk of its last completed transfer).
+    struct ReplaySource {
+        UdpAuth::ReplayWindow window;
+        std::uint64_t challenge = 0;
+        bool restarted = false;
+        std::uint64_t bulkFloor = 0;
+        std::int64_t lastSeen = 0;
+    };
+
+    Slot* newSlot();                  // receiver-owned; kept in slotStore_
+    int   addStream();                // -1 when the cap is reached
+    // Stream for a sender, registering it if allowed; nullptr: drop.
+    Stream* streamFor(const sockaddr_in& from);
+    bool  sourceAllowed(std::uint32_t addr, std::uint16_t port) const;
+    static std::uint64_t sourceKey(std::uint32_t addr, std::uint16_t port) {
+        return (std::uint64_t(1) << 48) | (std::uint64_t(addr) << 16) | port;
+    }
+    std::size_t tableIndex(std::uint64_t key) const {
+        return std::size_t((key * 0x9E3779B97F4A7C15ull) >> tableShift_);
+    }
+    // Loss / late / jitter accounting; false if seq is not newer than the
+    // stream's last one (late or duplicate).
+    static bool trackSeq(Stream& st, std::uint32_t seq, std::uint64_t ts, std::int64_t arrival);
+    void sendReports(std::int64_t now);
+
+    // True if the frame's payload and trailer fit in received bytes and
+    // count fits the buffer; checked before a frame touches any state.
+    bool frameComplete(std::uint32_t magic, const std::uint8_t* p, std::size_t received,
+                       std::uint16_t count, Endian e) const;
+
+    // Merges a sparse payload (length checked by frameComplete()) into the
+    // stream's state and writes it to slot; false if there is no matching
+    // base state.
+    bool mergeSparse(Stream& st, Slot& slot, const std::uint8_t* p, std::uint16_t count);
+
+    // Stores a bulk chunk received at now and acknowledges it to from.
+    void handleBulkChunk(const std::uint8_t* p, std::size_t received, const sockaddr_in& from, std::int64_t now);
+
+    // Sends a reply datagram of n bytes, tagged when auth is on (msg needs
+    // UdpAuth::TAG_BYTES of spare room).
+    void sendReply(std::uint8_t* msg, std::size_t n, const sockaddr_in& to);
+
+    // Hands a filled slot to the stream's readers, stores and pipelines;
+    // filled becomes the stream's previous back slot.
+    void publish(Stream& st, Slot*& filled);
+    // Queues the frame in spare_ until applyAt; false: publish it now.
+    bool holdFrame(Stream& st, std::int64_t applyAt, std::int64_t arrival);
+    // Publishes held frames due within the spin window, spinning to each.
+    void releaseDue();
+
+    // Answers a clock sync request (UdpClock.hpp) received at receivedNanos.
+    void answerClock(const std::uint8_t* p, std::size_t received, const sockaddr_in& from, std::int64_t receivedNanos);
+
+    // Answers a capability HELLO from the sender at from.
+    void answerHello(const std::uint8_t* p, std::size_t received, const sockaddr_in& from);
+    // Restarts the sender's replay window on a SESSION answering its challenge.
+    void startSession(const std::uint8_t* p, std::size_t received, const sockaddr_in& from);
+    ReplaySource& replaySource(const sockaddr_in& from, std::int64_t now);
+
+    bool hostLittle_ = false;
+
+    // Streams: one for the whole port, or one per sender with demux_.
+    // Entries [0, streamCount_) are immutable once published.
+    std::vector<std::unique_ptr<Slot>> slotStore_;   // receiver thread only
+    Slot* spare_ = nullptr;                          // recv target, receiver only
+    std::unique_ptr<std::unique_ptr<Stream>[]> streams_;
+    std::size_t streamCap_ = 1;
+    std::atomic<std::size_t> streamCount_{0};
+
+    // Source demux: flat hash of sourceKey() -> stream id
+    bool demux_ = false;
+    std::unique_ptr<SourceEntry[]> table_;
+    std::size_t tableMask_ = 0;
+    unsigned tableShift_ = 64;
+    std::size_t tableUsed_ = 0;                      // receiver thread only
+    std::vector<std::uint64_t> allowList_;           // fixed once started
+    std::atomic<std::uint64_t> oversizeDropped_{0};
+    std::atomic<std::uint64_t> rejectedPackets_{0};
+    std::int64_t lastRejectLog_ = INT64_MIN / 2;     // receiver thread only
+    std::uint64_t rejectsUnlogged_ = 0;
+
+    // receiver reports (receiver thread only)
+    std::int64_t reportIntervalNanos_ = 0;
+    std::int64_t nextReportNanos_ = 0;
+    std::uint32_t reportSeq_ = 0;
+
+    // bulk reassembly (receiver thread only, completed_ under bulkMutex_)
+    struct BulkState {
+        bool active = false;
+        std::uint64_t source = 0;
+        std::uint32_t id = 0;
+        std::uint32_t totalChunks = 0;
+        std::uint32_t totalDoubles = 0;
+        std::uint32_t chunkDoubles = 0;
+        std::uint32_t crc = 0;
+        std::uint32_t received = 0;
+        std::uint32_t cumulative = 0;
+        std::int64_t lastChunkNanos = 0;         // arrival of its last chunk
+        std::uint64_t newestSent = 0;            // latest chunk sentNanos
+        std::vector<std::uint8_t> bytes;         // BE payload as sent
+        std::vector<std::uint64_t> have;         // chunk bitmap
+        // last finished transfer, re-acknowledged for duplicates
+        std::uint64_t doneSource = 0;
+        std::uint32_t doneId = 0;
+        std::uint16_t doneFlags = 0;
+    };
+    std::size_t bulkMaxDoubles_ = 0;
+    BulkState bulk_;
+    std::mutex bulkMutex_;
+    std::deque<std::pair<std::uint32_t, std::vector<double>>> completed_;
+
+    std::atomic<bool> anyReorder_{false};           // skip the poll loop if never used
+
+    // apply-at release queue: min-heap on (applyAt, order), receiver thread
+    // only; stats under releaseMutex_
+    struct Held {
+        std::int64_t applyAt = 0;
+        std::uint64_t order = 0;                     // arrival order among equal times
+        Stream* stream = nullptr;
+        Slot* slot = nullptr;
+    };
+    static bool heldLater(const Held& a, const Held& b);
+    std::vector<Held> held_;
+    std::vector<Slot*> freeSlots_;                   // released hold slots
+    std::uint64_t heldOrder_ = 0;
+    std::size_t maxHeld_ = 64;
+    std::int64_t maxHoldNanos_ = 1'000'000'000;
+    std::int64_t releaseSpinNanos_;
+    mutable std::mutex releaseMutex_;
+    ReleaseStats releaseStats_;
+    double releaseErrorSum_ = 0.0;
+    double releaseAbsErrorSum_ = 0.0;
+
+    std::unique_ptr<UdpAuth> auth_;                  // fixed once started
+    std::atomic<std::uint64_t> authRejected_{0};
+    std::atomic<std::uint64_t> replayRejected_{0};
+
+    // Replay state per sourceKey() (see ReplaySource), receiver thread only.
+    static constexpr std::size_t MAX_REPLAY_SOURCES = 1024;   // least recently seen evicted
+    std::map<std::uint64_t, ReplaySource> replaySources_;
+    std::mt19937_64 challengeRng_;
+
+    // waiting: receiver thread strategy, blocked waitLatest() callers
+    std::unique_ptr<WaitStrategy> wait_;
+    std::mutex publishMutex_;
+    std::condition_variable publishCv_;
+    std::atomic<int> blockedReaders_{0};
+
+    std::vector<double> storeRow_;                   // decoded frame for stores / pipelines / triggers
+
+    // Channel subscriptions (refcounted); the receiver reads subMask_ only.
+    std::size_t maxChannels_ = 0;
+    std::size_t maskWords_ = 0;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> subMask_;
+    std::atomic<bool> anySubscribed_{false};
+    std::mutex subMutex_;
+    std::vector<std::uint32_t> subRefs_;
+    std::map<int, std::vector<std::uint16_t>> subscriptions_;
+    int nextSubId_ = 1;
+};
+
+// Decode-on-access view of one published frame (see getLatestView).
+class UdpDoubleReceiver::FrameView {
+public:
+    FrameView() = default;
+
+    std::uint32_t seq() const { return slot_->seq; }
+    std::uint64_t timestampNanos() const { return slot_->timestampNanos; }
+    std::int64_t  arrivalNanos() const { return slot_->arrivalNanos; }
+    std::int64_t  applyAtNanos() const { return slot_->applyAtNanos; }
+    std::size_t   count() const { return slot_->count; }
+
+    // Single channel; i must be < count().
+    double get(std::size_t i) const { return owner_->decodeChannel(*slot_, i); }
+
+    // Decodes the listed channels into out[0..n). Indices >= count() give NaN.
+    void decode(const std::uint16_t* indices, std::size_t n, double* out) const;
+
+    // Raw datagram (header + payload, sender endian for undecoded channels).
+    // For merged sparse updates the payload holds the merged host-order state.
+    const std::uint8_t* raw() const { return slot_->wire(); }
+
+    void release() { lock_ = std::unique_lock<std::mutex>(); slot_ = nullptr; }
+
+private:
+    friend class UdpDoubleReceiver;
+    std::unique_lock<std::mutex> lock_;
+    const UdpDoubleReceiver* owner_ = nullptr;
+    const Slot* slot_ = nullptr;
 };
@@ -1,9 +1,22 @@
 #include "UdpDoubleSender.hpp"
+#include "UdpCapabilities.hpp"
+#include "UdpReport.hpp"
+#include "UdpAuth.hpp"
+#include "UdpClock.hpp"
+#include "UdpBulk.hpp"
+#include "UdpWire.hpp"
+#include "SteadyClock.hpp"
 
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <iostream>
 
 #if !defined(_WIN32)
   #include <arpa/inet.h>
@@ -11,6 +24,8 @@
   #include <netdb.h>
   #include <unistd.h>
   #include <netinet/in.h>
+  #include <sys/select.h>
+  #include <sys/uio.h>
 #endif
 
 #ifdef _MSC_VER
@@ -39,6 +54,152 @@ struct UdpDoubleSender::WinsockRAII {
 };
 #endif
 
+// ---------- destination (seqlock-published, background resolver) ----------
+struct UdpDoubleSender::Destination {
+    static constexpr size_t WORDS = sizeof(sockaddr_storage) / 8;
+
+    std::atomic<uint32_t> seq{0};
+    std::atomic<uint64_t> words[WORDS];
+    std::atomic<uint32_t> len{0};          // 0 = not resolved yet
+
+    // resolver state (guarded by mtx)
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    std::thread thread;
+    std::string host;
+    uint16_t port = 0;
+    int family = 0;
+    bool connectUdp = false;
+    decltype(UdpDoubleSender::sock_) sock{};
+    int64_t intervalNanos = 0;
+    bool trigger = false;
+    bool stopping = false;
+    ResolveStats stats;
+    std::atomic<uint64_t> unresolvedDrops{0};
+
+    Destination() { for (auto& w : words) w.store(0, std::memory_order_relaxed); }
+
+    // single writer (resolver thread or owner before it starts)
+    void publish(const sockaddr_storage& a, socklen_t l) {
+        uint64_t tmp[WORDS];
+        std::memcpy(tmp, &a, sizeof(tmp));
+        seq.fetch_add(1, std::memory_order_acq_rel);          // odd: writing
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) words[i].store(tmp[i], std::memory_order_relaxed);
+        len.store((uint32_t)l, std::memory_order_relaxed);
+        seq.fetch_add(1, std::memory_order_release);          // even: stable
+    }
+
+    // wait-free unless a swap is in progress; returns 0 if unresolved
+    socklen_t read(sockaddr_storage& out) const {
+        uint64_t tmp[WORDS];
+        uint32_t l, s1, s2;
+        do {
+            s1 = seq.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; ++i) tmp[i] = words[i].load(std::memory_order_relaxed);
+            l = len.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            s2 = seq.load(std::memory_order_relaxed);
+        } while ((s1 & 1u) || s1 != s2);
+        std::memcpy(&out, tmp, sizeof(tmp));
+        return (socklen_t)l;
+    }
+
+    void run();
+};
+
+void UdpDoubleSender::Destination::run() {
+    using clock = std::chrono::steady_clock;
+    std::unique_lock<std::mutex> lk(mtx);
+    while (!stopping) {
+        if (!trigger) {
+            auto pred = [this] { return trigger || stopping; };
+            if (intervalNanos > 0) cv.wait_for(lk, std::chrono::nanoseconds(intervalNanos), pred);
+            else cv.wait(lk, pred);
+        }
+        if (stopping) break;
+        trigger = false;
+
+        const std::string h = host;
+        const std::string portStr = std::to_string(port);
+        lk.unlock();
+
+        addrinfo hints{};
+        hints.ai_socktype = SOCK_DGRAM;
+        hints.ai_protocol = IPPROTO_UDP;
+        hints.ai_family   = family;
+        addrinfo* res = nullptr;
+        const auto t0 = clock::now();
+        const int rc = getaddrinfo(h.c_str(), portStr.c_str(), &hints, &res);
+        const int64_t latency = (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t0).count();
+
+        sockaddr_storage addr{};
+        socklen_t addrLen = 0;
+        if (rc == 0 && res) {
+            std::memcpy(&addr, res->ai_addr, (size_t)res->ai_addrlen);
+            addrLen = (socklen_t)res->ai_addrlen;
+        }
+        if (res) freeaddrinfo(res);
+
+        std::string error;
+        bool swapped = false;
+        if (addrLen == 0) {
+#if defined(_WIN32)
+            error = "getaddrinfo failed: rc=" + std::to_string(rc);
+#else
+            error = std::string("getaddrinfo failed: ") + gai_strerror(rc);
+#endif
+        } else {
+            sockaddr_storage cur{};
+            const socklen_t curLen = read(cur);
+            if (curLen != addrLen || std::memcmp(&cur, &addr, (size_t)addrLen) != 0) {
+                if (connectUdp && ::connect(sock, (sockaddr*)&addr, addrLen) != 0) {
+                    error = "connect failed: " + UdpDoubleSender::lastSockErr_();
+                } else {
+                    publish(addr, addrLen);
+                    swapped = true;
+                }
+            }
+        }
+
+        lk.lock();
+        ++stats.attempts;
+        stats.lastLatencyNanos = latency;
+        stats.maxLatencyNanos = std::max(stats.maxLatencyNanos, latency);
+        if (!error.empty()) {
+            ++stats.failures;
+            stats.lastError = error;
+        } else {
+            stats.resolved = true;
+            if (swapped) ++stats.swaps;
+        }
+    }
+}
+
+// ---------- reply demux (one queue per kind, guarded by mtx) ----------
+struct UdpDoubleSender::ReplyQueues {
+    static constexpr size_t KINDS = (size_t)Reply::Other + 1;
+
+    struct Item {
+        std::vector<uint8_t> bytes;   // tag already stripped
+        int64_t receivedNanos = 0;
+    };
+
+    std::mutex mtx;
+    std::deque<Item> queues[KINDS];
+
+    static Reply kindOf(const uint8_t* p, size_t n) {
+        if (n < 4) return Reply::Other;
+        switch (UdpWire::get32(p)) {
+        case UdpCapabilities::MAGIC_ACK: return Reply::Handshake;
+        case UdpClock::MAGIC_REPLY:      return Reply::Clock;
+        case UdpReport::MAGIC_REPORT:    return Reply::Report;
+        case UdpBulk::MAGIC_ACK:         return Reply::BulkAck;
+        default:                         return Reply::Other;
+        }
+    }
+};
+
 // ---------- endian helpers ----------
 bool UdpDoubleSender::isLittleEndian_() {
     uint16_t one = 1;
@@ -99,6 +260,36 @@ void UdpDoubleSender::writeDoubleBE_(uint8_t* dst, double d) {
     std::memcpy(dst, &bits, sizeof(bits));
 }
 
+void UdpDoubleSender::writeWire16_(uint8_t* dst, uint16_t v) const {
+    if (wireLittle_) { dst[0] = (uint8_t)v; dst[1] = (uint8_t)(v >> 8); }
+    else writeBE16_(dst, v);
+}
+
+void UdpDoubleSender::writeWire32_(uint8_t* dst, uint32_t v) const {
+    if (wireLittle_) { for (int i = 0; i < 4; ++i) dst[i] = (uint8_t)(v >> (8 * i)); }
+    else writeBE32u_(dst, v);
+}
+
+void UdpDoubleSender::writeWire64_(uint8_t* dst, uint64_t v) const {
+    if (wireLittle_ != isLittleEndian_()) v = bswap64_(v);
+    std::memcpy(dst, &v, sizeof(v));
+}
+
+void UdpDoubleSender::writeWireDouble_(uint8_t* dst, double d) const {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &d, sizeof(bits));
+    writeWire64_(dst, bits);
+}
+
+void UdpDoubleSender::writeHeader_(uint8_t* dst, uint32_t magic, uint16_t count,
+                                   int32_t seq, int64_t timestampNanos) const {
+    writeWire32_(dst + 0, magic);
+    writeWire16_(dst + 4, VERSION);
+    writeWire16_(dst + 6, count);
+    writeWire32_(dst + 8, (uint32_t)seq);
+    writeWire64_(dst + 12, (uint64_t)timestampNanos);
+}
+
 // ---------- misc ----------
 int UdpDoubleSender::desiredFamily_(IpMode m) {
     switch (m) {
@@ -117,28 +308,22 @@ bool UdpDoubleSender::isOpen_() const {
 }
 
 void UdpDoubleSender::closeSock_() {
+    stopResolver_();
 #if defined(_WIN32)
     if (sock_ != INVALID_SOCKET) { closesocket(sock_); sock_ = INVALID_SOCKET; }
 #else
     if (sock_ >= 0) { ::close(sock_); sock_ = -1; }
 #endif
     family_ = 0;
-    destAddrLen_ = 0;
-    std::memset(&destAddr_, 0, sizeof(destAddr_));
 }
 
 void UdpDoubleSender::initTimestampOffset_() {
-    using namespace std::chrono;
-    const int64_t now = (int64_t)duration_cast<nanoseconds>(
-        steady_clock::now().time_since_epoch()).count();
+    const int64_t now = SteadyClock::nowNanos();
     tsOffset_ = (now < 0) ? -now : 0;
 }
 
 int64_t UdpDoubleSender::monotonicNowNanosNonNegative_() const {
-    using namespace std::chrono;
-    const int64_t now = (int64_t)duration_cast<nanoseconds>(
-        steady_clock::now().time_since_epoch()).count();
-    return now + tsOffset_;
+    return SteadyClock::nowNanos() + tsOffset_;
 }
 
 // ---------- ctor/dtor ----------
@@ -149,8 +334,11 @@ UdpDoubleSender::UdpDoubleSender(const std::string& remoteHost,
                                    bool connectUdp,
                                    int maxPayloadBytes,
                                    IpMode ipMode,
-                                   int requestedSndBuf)
-: remoteHost_(remoteHost),
+                                   int requestedSndBuf,
+                                   bool resolveInBackground)
+: dest_(new Destination()),
+  replies_(new ReplyQueues()),
+  remoteHost_(remoteHost),
   remotePort_(remotePort),
   connect_(connectUdp),
   ipMode_(ipMode)
@@ -160,13 +348,20 @@ UdpDoubleSender::UdpDoubleSender(const std::string& remoteHost,
 #endif
 
     const int payloadLimit = (maxPayloadBytes > 0) ? maxPayloadBytes : DEFAULT_MAX_UDP_PAYLOAD;
-    const int maxByPayload = std::max(0, (payloadLimit - HEADER_BYTES) / 8);
-    maxDoubles_ = std::max(0, std::min(maxDoubles, maxByPayload));
-
-    buffer_.resize((size_t)HEADER_BYTES + (size_t)maxDoubles_ * 8);
+    maxPayloadBytes_.store(payloadLimit, std::memory_order_relaxed);
+    requestedMaxDoubles_ = std::max(0, maxDoubles);
+    recomputeLimits_();
+    // never resized: the limits only ever shrink below the request
+    buffer_.resize((size_t)HEADER_BYTES + (size_t)std::min(requestedMaxDoubles_, 0xFFFF) * 8);
 
     initTimestampOffset_();
-    createAndConfigureSocket_(localPort, requestedSndBuf);
+    if (resolveInBackground) {
+        createUnresolvedSocket_(localPort, requestedSndBuf);
+        startResolver_();
+        requestResolve();
+    } else {
+        createAndConfigureSocket_(localPort, requestedSndBuf);
+    }
 }
 
 UdpDoubleSender::~UdpDoubleSender() {
@@ -193,21 +388,45 @@ UdpDoubleSender& UdpDoubleSender::operator=(UdpDoubleSender&& other) noexcept {
 }
 
 void UdpDoubleSender::moveFrom_(UdpDoubleSender&& o) noexcept {
+    dest_ = std::move(o.dest_);   // resolver thread only references *dest_
+    replies_ = std::move(o.replies_);
     remoteHost_ = std::move(o.remoteHost_);
     remotePort_ = o.remotePort_;
     connect_ = o.connect_;
     ipMode_ = o.ipMode_;
 
     family_ = o.family_;
-    destAddr_ = o.destAddr_;
-    destAddrLen_ = o.destAddrLen_;
 
-    maxDoubles_ = o.maxDoubles_;
-    seq_ = o.seq_;
+    maxDoubles_.store(o.maxDoubles_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    seq_.store(o.seq_.load(std::memory_order_relaxed), std::memory_order_relaxed);
     buffer_ = std::move(o.buffer_);
 
+    deadbands_ = std::move(o.deadbands_);
+    lastSent_ = std::move(o.lastSent_);
+    lastSentCount_ = o.lastSentCount_;
+    fullRefreshInterval_ = o.fullRefreshInterval_;
+    framesSinceFull_ = o.framesSinceFull_;
+    sparseActive_.store(o.sparseActive_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
     tsOffset_ = o.tsOffset_;
 
+    maxPayloadBytes_.store(o.maxPayloadBytes_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    requestedMaxDoubles_ = o.requestedMaxDoubles_;
+    pathMtu_.store(o.pathMtu_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    peerMaxPayload_ = o.peerMaxPayload_;
+    peerMaxChannels_ = o.peerMaxChannels_;
+    maxFrameBytes_.store(o.maxFrameBytes_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    wireLittle_ = o.wireLittle_;
+    sparseAllowed_ = o.sparseAllowed_;
+    previewAllowed_ = o.previewAllowed_;
+    applyAtAllowed_ = o.applyAtAllowed_;
+    negotiated_ = o.negotiated_;
+    helloNonce_ = o.helloNonce_;
+    auth_ = std::move(o.auth_);
+    clockSynced_ = o.clockSynced_;
+    clockOffset_ = o.clockOffset_;
+    clockRtt_ = o.clockRtt_;
+
 #if defined(_WIN32)
     sock_ = o.sock_;
     o.sock_ = INVALID_SOCKET;
@@ -217,8 +436,6 @@ void UdpDoubleSender::moveFrom_(UdpDoubleSender&& o) noexcept {
 #endif
 
     o.family_ = 0;
-    o.destAddrLen_ = 0;
-    std::memset(&o.destAddr_, 0, sizeof(o.destAddr_));
 }
 
 // ---------- socket setup ----------
@@ -283,13 +500,8 @@ void UdpDoubleSender::createAndConfigureSocket_(uint16_t localPort, int requeste
             continue;
         }
 
-        std::memset(&destAddr_, 0, sizeof(destAddr_));
-        std::memcpy(&destAddr_, ai->ai_addr, (size_t)ai->ai_addrlen);
-        destAddrLen_ = (socklen_t)ai->ai_addrlen;
-        family_ = (int)ai->ai_family;
-
         if (connect_) {
-            if (::connect(s, (sockaddr*)&destAddr_, destAddrLen_) != 0) {
+            if (::connect(s, ai->ai_addr, (socklen_t)ai->ai_addrlen) != 0) {
 #if defined(_WIN32)
                 closesocket(s);
 #else
@@ -300,6 +512,10 @@ void UdpDoubleSender::createAndConfigureSocket_(uint16_t localPort, int requeste
         }
 
         sock_ = s;
+        family_ = (int)ai->ai_family;
+        sockaddr_storage addr{};
+        std::memcpy(&addr, ai->ai_addr, (size_t)ai->ai_addrlen);
+        dest_->publish(addr, (socklen_t)ai->ai_addrlen);   // the only copy of the destination
         freeaddrinfo(res);
         return;
     }
@@ -308,8 +524,203 @@ void UdpDoubleSender::createAndConfigureSocket_(uint16_t localPort, int requeste
     throw std::runtime_error("Failed to create usable UDP socket for any resolved address");
 }
 
+// ---------- background resolution ----------
+void UdpDoubleSender::createUnresolvedSocket_(uint16_t localPort, int requestedSndBuf) {
+    const int fam = (ipMode_ == IpMode::IPv6) ? AF_INET6 : AF_INET;
+#if defined(_WIN32)
+    SOCKET s = ::socket(fam, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET)
+#else
+    int s = ::socket(fam, SOCK_DGRAM, IPPROTO_UDP);
+    if (s < 0)
+#endif
+        throw std::runtime_error("socket() failed: " + lastSockErr_());
+
+    if (requestedSndBuf > 0) {
+        setsockopt(s, SOL_SOCKET, SO_SNDBUF,
+                   (const char*)&requestedSndBuf, (socklen_t)sizeof(requestedSndBuf));
+    }
+    if (!bindLocal_(s, fam, localPort)) {
+        const std::string err = lastSockErr_();
+#if defined(_WIN32)
+        closesocket(s);
+#else
+        ::close(s);
+#endif
+        throw std::runtime_error("bind failed: " + err);
+    }
+
+    sock_ = s;
+    family_ = fam;
+}
+
+void UdpDoubleSender::startResolver_() {
+    if (!dest_ || dest_->thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lk(dest_->mtx);
+        dest_->host = remoteHost_;
+        dest_->port = remotePort_;
+        dest_->family = family_;
+        dest_->connectUdp = connect_;
+        dest_->sock = sock_;
+        dest_->stopping = false;
+    }
+    dest_->thread = std::thread(&Destination::run, dest_.get());
+}
+
+void UdpDoubleSender::stopResolver_() {
+    if (!dest_ || !dest_->thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lk(dest_->mtx);
+        dest_->stopping = true;
+    }
+    dest_->cv.notify_all();
+    dest_->thread.join();
+}
+
+void UdpDoubleSender::setDestination(const std::string& remoteHost, uint16_t remotePort) {
+    if (!isOpen_()) throw std::runtime_error("socket not open");
+    remoteHost_ = remoteHost;
+    remotePort_ = remotePort;
+    startResolver_();
+    {
+        std::lock_guard<std::mutex> lk(dest_->mtx);
+        dest_->host = remoteHost;
+        dest_->port = remotePort;
+        dest_->trigger = true;
+    }
+    dest_->cv.notify_all();
+}
+
+void UdpDoubleSender::requestResolve() {
+    if (!isOpen_()) return;
+    startResolver_();
+    {
+        std::lock_guard<std::mutex> lk(dest_->mtx);
+        dest_->trigger = true;
+    }
+    dest_->cv.notify_all();
+}
+
+void UdpDoubleSender::setReresolveInterval(int intervalMs) {
+    if (!isOpen_()) return;
+    startResolver_();
+    {
+        std::lock_guard<std::mutex> lk(dest_->mtx);
+        dest_->intervalNanos = (intervalMs > 0) ? (int64_t)intervalMs * 1000000 : 0;
+    }
+    dest_->cv.notify_all();
+}
+
+bool UdpDoubleSender::isResolved() const {
+    if (!dest_) return false;
+    return dest_->len.load(std::memory_order_acquire) != 0;
+}
+
+UdpDoubleSender::ResolveStats UdpDoubleSender::getResolveStats() const {
+    if (!dest_) return ResolveStats();
+    std::lock_guard<std::mutex> lk(dest_->mtx);
+    ResolveStats s = dest_->stats;
+    s.resolved = dest_->len.load(std::memory_order_acquire) != 0;
+    s.unresolvedDrops = dest_->unresolvedDrops.load(std::memory_order_relaxed);
+    return s;
+}
+
+// ---------- limits / path MTU ----------
+void UdpDoubleSender::recomputeLimits_() {
+    int payload = maxPayloadBytes_.load(std::memory_order_relaxed);
+    if (peerMaxPayload_ > 0) payload = std::min(payload, peerMaxPayload_);
+    if (auth_) payload -= (int)UdpAuth::TAG_BYTES;   // the tag rides in the same datagram
+
+    maxFrameBytes_.store(std::max(0, payload), std::memory_order_relaxed);
+
+    int doubles = std::min(requestedMaxDoubles_, std::max(0, (payload - HEADER_BYTES) / 8));
+    if (peerMaxChannels_ > 0) doubles = std::min(doubles, peerMaxChannels_);
+    maxDoubles_.store(std::max(0, std::min(doubles, 0xFFFF)), std::memory_order_relaxed);   // count is 16-bit on the wire
+}
+
+int UdpDoubleSender::getEffectiveMaxPayload() const {
+    return HEADER_BYTES + maxDoubles_.load(std::memory_order_relaxed) * 8;
+}
+
+bool UdpDoubleSender::lastErrorIsMsgSize_() {
+#if defined(_WIN32)
+    return WSAGetLastError() == WSAEMSGSIZE;
+#else
+    return errno == EMSGSIZE;
+#endif
+}
+
+bool UdpDoubleSender::setDontFragment_() {
+    if (family_ == AF_INET) {
+#if defined(IP_MTU_DISCOVER) && defined(IP_PMTUDISC_DO)
+        int v = IP_PMTUDISC_DO;
+        return setsockopt(sock_, IPPROTO_IP, IP_MTU_DISCOVER, (const char*)&v, (socklen_t)sizeof(v)) == 0;
+#elif defined(IP_DONTFRAGMENT)
+        DWORD v = 1;
+        return setsockopt(sock_, IPPROTO_IP, IP_DONTFRAGMENT, (const char*)&v, (socklen_t)sizeof(v)) == 0;
+#endif
+    } else if (family_ == AF_INET6) {
+#if defined(IPV6_MTU_DISCOVER) && defined(IPV6_PMTUDISC_DO)
+        int v = IPV6_PMTUDISC_DO;
+        return setsockopt(sock_, IPPROTO_IPV6, IPV6_MTU_DISCOVER, (const char*)&v, (socklen_t)sizeof(v)) == 0;
+#elif defined(IPV6_DONTFRAG)
+        int v = 1;
+        return setsockopt(sock_, IPPROTO_IPV6, IPV6_DONTFRAG, (const char*)&v, (socklen_t)sizeof(v)) == 0;
+#endif
+    }
+    return false;
+}
+
+int UdpDoubleSender::readPathMtu_() const {
+    if (!connect_) return 0;   // the kernel tracks path MTU per connected peer
+    int mtu = 0;
+    socklen_t len = (socklen_t)sizeof(mtu);
+    if (family_ == AF_INET) {
+#if defined(IP_MTU)
+        if (getsockopt(sock_, IPPROTO_IP, IP_MTU, (char*)&mtu, &len) != 0) return 0;
+#endif
+    } else if (family_ == AF_INET6) {
+#if defined(IPV6_MTU)
+        if (getsockopt(sock_, IPPROTO_IPV6, IPV6_MTU, (char*)&mtu, &len) != 0) return 0;
+#endif
+    }
+    return mtu;
+}
+
+int UdpDoubleSender::probePathMtu(bool sendProbe) {
+    if (!isOpen_()) throw std::runtime_error("socket not open");
+    std::lock_guard<std::mutex> lock(limitsMutex_);
+    setDontFragment_();
+
+    int mtu = readPathMtu_();
+    if (mtu <= 0) return 0;
+
+    if (sendProbe) {
+        // One DF datagram at the current estimate; a local EMSGSIZE (or a
+        // later ICMP "fragmentation needed") lowers the kernel's value. Never
+        // larger than the peer accepts: its receive buffer would overflow.
+        const int ipHeader = (family_ == AF_INET6) ? 40 : 20;
+        int probePayload = mtu - ipHeader - 8;
+        if (peerMaxPayload_ > 0) probePayload = std::min(probePayload, peerMaxPayload_);
+        const size_t probeBytes = (size_t)std::max(HEADER_BYTES, probePayload);
+        std::vector<uint8_t> probe(probeBytes, 0);
+        writeBE32u_(probe.data(), 0x55445050u); // "UDPP"
+        writeBE16_(probe.data() + 4, VERSION);
+        ::send(sock_, (const char*)probe.data(), (int)probe.size(), 0);   // result only via IP_MTU
+        const int again = readPathMtu_();
+        if (again > 0) mtu = again;
+    }
+
+    pathMtu_.store(mtu, std::memory_order_relaxed);
+    const int ipHeader = (family_ == AF_INET6) ? 40 : 20;
+    maxPayloadBytes_.store(std::max(HEADER_BYTES, mtu - ipHeader - 8), std::memory_order_relaxed);
+    recomputeLimits_();
+    return getEffectiveMaxPayload();
+}
+
 // ---------- public API ----------
-int UdpDoubleSender::getMaxDoubles() const { return maxDoubles_; }
+int UdpDoubleSender::getMaxDoubles() const { return maxDoubles_.load(std::memory_order_relaxed); }
 
 int UdpDoubleSender::getSendBufferBytes() const {
     if (!isOpen_()) return 0;
@@ -363,53 +774,525 @@ void UdpDoubleSender::setMulticastInterfaceIPv6(unsigned int ifIndex) {
 }
 
 size_t UdpDoubleSender::sendAutoSeq(const double* data, int count) {
-    return sendWithSeq(data, count, seq_++);
+    return sendWithSeq(data, count, seq_.fetch_add(1, std::memory_order_relaxed));
 }
 
 size_t UdpDoubleSender::sendWithSeq(const double* data, int count, int32_t seq, int64_t timestampNanos) {
     if (!data) throw std::invalid_argument("data is null");
     if (count <= 0) return 0;
-    if (count > maxDoubles_) throw std::invalid_argument("count > maxDoubles/payload cap");
+    if (count > maxDoubles_.load(std::memory_order_relaxed)) throw std::invalid_argument("count > maxDoubles/payload cap");
     if (!isOpen_()) throw std::runtime_error("socket not open");
 
     if (timestampNanos == INT64_MIN) {
         timestampNanos = monotonicNowNanosNonNegative_();
     }
 
+    // Per-thread encode buffer: concurrent producers never share bytes.
+    thread_local std::vector<uint8_t> tlsBuffer;
+    const size_t need = (size_t)HEADER_BYTES + (size_t)count * 8;
+    if (tlsBuffer.size() < need) tlsBuffer.resize(std::max(need, buffer_.size()));
+
+    const size_t bytes = encodeFull_(tlsBuffer.data(), data, count, seq, timestampNanos);
+    return transmitFullState_(tlsBuffer.data(), bytes, data, count);
+}
+
+size_t UdpDoubleSender::transmitFullState_(const uint8_t* buf, size_t bytes, const double* data, int count) {
+    if (!sparseActive_.load(std::memory_order_acquire)) return transmit_(buf, bytes);
+
+    std::lock_guard<std::mutex> lock(sparseMutex_);
+    const size_t sent = transmit_(buf, bytes);
+    if (sent) rebaseSparse_(data, count);
+    return sent;
+}
+
+void UdpDoubleSender::rebaseSparse_(const double* data, int count) {
+    lastSent_.assign(data, data + count);
+    lastSentCount_ = count;
+    framesSinceFull_ = 0;
+}
+
+size_t UdpDoubleSender::encodeFull_(uint8_t* buf, const double* data, int count, int32_t seq, int64_t timestampNanos) const {
     const uint16_t n = (uint16_t)count;
     const size_t bytes = (size_t)HEADER_BYTES + (size_t)n * 8;
 
-    uint8_t* buf = buffer_.data();
-
-    // Header (matches Java exactly)
-    writeBE32u_(buf + 0, MAGIC);
-    writeBE16_ (buf + 4, VERSION);
-    writeBE16_ (buf + 6, n);
-    writeBE32_fromBits_(buf + 8, seq);
-    writeBE64_fromBits_(buf + 12, timestampNanos);
+    // Header (matches Java exactly when BE)
+    writeHeader_(buf, MAGIC, n, seq, timestampNanos);
 
     // Payload
     uint8_t* p = buf + HEADER_BYTES;
-    for (uint16_t i = 0; i < n; ++i) {
-        writeDoubleBE_(p + (size_t)i * 8, data[i]);
-    }
-
-    int sent;
-    if (connect_) {
-        sent = ::send(sock_, (const char*)buf, (int)bytes, 0);
+    if (wireLittle_) {
+        for (uint16_t i = 0; i < n; ++i) writeWireDouble_(p + (size_t)i * 8, data[i]);
     } else {
-        sent = ::sendto(sock_, (const char*)buf, (int)bytes, 0,
-                        (sockaddr*)&destAddr_, destAddrLen_);
+        for (uint16_t i = 0; i < n; ++i) writeDoubleBE_(p + (size_t)i * 8, data[i]);
     }
 
+    return bytes;
+}
+
+size_t UdpDoubleSender::transmit_(const uint8_t* buf, size_t bytes) {
+    for (int attempt = 0; ; ++attempt) {
+        sockaddr_storage dest;
+        const socklen_t destLen = dest_ ? dest_->read(dest) : 0;
+        if (destLen == 0) {
+            if (dest_) dest_->unresolvedDrops.fetch_add(1, std::memory_order_relaxed);
+            return 0;   // background resolution still pending
+        }
+
+        int sent;
+        if (auth_) {
+            // tag over the encoded bytes while they are still in L1; sent
+            // as a second buffer so callers need no spare room
+            uint8_t tag[UdpAuth::TAG_BYTES];
+            const uint64_t t = auth_->tag(buf, bytes);
+            for (int i = 0; i < 8; ++i) tag[i] = (uint8_t)(t >> (56 - 8 * i));
+#if defined(_WIN32)
+            WSABUF parts[2];
+            parts[0].buf = (CHAR*)buf;
+            parts[0].len = (ULONG)bytes;
+            parts[1].buf = (CHAR*)tag;
+            parts[1].len = (ULONG)sizeof(tag);
+            DWORD n = 0;
+            const int rc = connect_ ? WSASend(sock_, parts, 2, &n, 0, nullptr, nullptr)
+                                    : WSASendTo(sock_, parts, 2, &n, 0, (sockaddr*)&dest, destLen, nullptr, nullptr);
+            sent = (rc == 0) ? (int)n : SOCKET_ERROR;
+#else
+            iovec parts[2];
+            parts[0].iov_base = (void*)buf;
+            parts[0].iov_len = bytes;
+            parts[1].iov_base = tag;
+            parts[1].iov_len = sizeof(tag);
+            msghdr m{};
+            m.msg_iov = parts;
+            m.msg_iovlen = 2;
+            if (!connect_) {
+                m.msg_name = &dest;
+                m.msg_namelen = destLen;
+            }
+            sent = (int)::sendmsg(sock_, &m, 0);
+#endif
+        } else if (connect_) {
+            sent = ::send(sock_, (const char*)buf, (int)bytes, 0);
+        } else {
+            sent = ::sendto(sock_, (const char*)buf, (int)bytes, 0,
+                            (sockaddr*)&dest, destLen);
+        }
+
 #if defined(_WIN32)
-    if (sent == SOCKET_ERROR)
+        if (sent != SOCKET_ERROR) return (size_t)sent;
 #else
-    if (sent < 0)
+        if (sent >= 0) return (size_t)sent;
 #endif
+        // Path MTU shrank (DF set): learn the new size, retry once if it fits.
+        if (attempt == 0 && lastErrorIsMsgSize_() && pathMtu_.load(std::memory_order_relaxed) > 0) {
+            const std::string err = lastSockErr_();
+            probePathMtu(false);
+            if ((int)bytes <= getEffectiveMaxPayload()) continue;
+            throw std::runtime_error("send failed: datagram exceeds path MTU (" + err +
+                                     "), maxDoubles now " + std::to_string(getMaxDoubles()));
+        }
         throw std::runtime_error("send/sendto failed: " + lastSockErr_());
+    }
+}
+
+// ---------- sparse updates ----------
+void UdpDoubleSender::setDeadbands(const double* deadbands, int count) {
+    const int maxDoubles = getMaxDoubles();
+    deadbands_.assign((size_t)std::max(0, maxDoubles), 0.0);
+    if (!deadbands) return;
+    const int n = std::min(count, maxDoubles);
+    for (int i = 0; i < n; ++i) deadbands_[(size_t)i] = std::fabs(deadbands[i]);
+}
+
+void UdpDoubleSender::setFullRefreshInterval(int frames) {
+    fullRefreshInterval_ = std::max(1, frames);
+}
+
+bool UdpDoubleSender::changed_(double now, double last, double deadband) {
+    if (std::isnan(now) || std::isnan(last)) return std::isnan(now) != std::isnan(last);
+    if (deadband <= 0.0) return now != last;
+    return std::fabs(now - last) > deadband;
+}
+
+size_t UdpDoubleSender::sendSparseAutoSeq(const double* data, int count) {
+    return sendSparseWithSeq(data, count, seq_.fetch_add(1, std::memory_order_relaxed));
+}
+
+size_t UdpDoubleSender::sendSparseWithSeq(const double* data, int count, int32_t seq, int64_t timestampNanos) {
+    if (!data) throw std::invalid_argument("data is null");
+    if (count <= 0) return 0;
+    if (count > maxDoubles_.load(std::memory_order_relaxed)) throw std::invalid_argument("count > maxDoubles/payload cap");
+    if (!isOpen_()) throw std::runtime_error("socket not open");
+
+    if (timestampNanos == INT64_MIN) {
+        timestampNanos = monotonicNowNanosNonNegative_();
+    }
+
+    std::lock_guard<std::mutex> lock(sparseMutex_);
+    sparseActive_.store(true, std::memory_order_release);
+
+    const bool needFull = lastSentCount_ != count ||
+                          ++framesSinceFull_ >= fullRefreshInterval_;
+
+    // Bitmap is padded to 8 bytes so the values stay 8-byte aligned.
+    const size_t bitmapBytes = (((size_t)count + 63) / 64) * 8;
+    uint8_t* buf = buffer_.data();
+    uint8_t* bitmap = buf + HEADER_BYTES;
+
+    int changedCount = 0;
+    if (!needFull) {
+        std::memset(bitmap, 0, bitmapBytes);
+        for (int i = 0; i < count; ++i) {
+            const double db = ((size_t)i < deadbands_.size()) ? deadbands_[(size_t)i] : 0.0;
+            if (changed_(data[i], lastSent_[(size_t)i], db)) {
+                bitmap[i >> 3] |= (uint8_t)(1u << (i & 7));
+                ++changedCount;
+            }
+        }
+    }
+
+    const size_t sparseBytes = (size_t)HEADER_BYTES + bitmapBytes + (size_t)changedCount * 8;
+    const size_t fullBytes = (size_t)HEADER_BYTES + (size_t)count * 8;
+    // The baseline only moves once the frame is out: a throw or an
+    // unresolved destination (0) leaves it where the receiver is.
+    if (needFull || !sparseAllowed_ || sparseBytes >= fullBytes) {
+        const size_t sent = transmit_(buf, encodeFull_(buf, data, count, seq, timestampNanos));
+        if (sent) rebaseSparse_(data, count);
+        return sent;
+    }
+
+    writeHeader_(buf, MAGIC_SPARSE, (uint16_t)count, seq, timestampNanos);
+
+    uint8_t* p = bitmap + bitmapBytes;
+    for (int i = 0; i < count; ++i) {
+        if (bitmap[i >> 3] & (1u << (i & 7))) {
+            writeWireDouble_(p, data[i]);
+            p += 8;
+        }
+    }
+
+    const size_t sent = transmit_(buf, sparseBytes);
+    if (sent) {
+        for (int i = 0; i < count; ++i)
+            if (bitmap[i >> 3] & (1u << (i & 7))) lastSent_[(size_t)i] = data[i];
+    }
+    return sent;
+}
+
+// ---------- trajectory preview ----------
+size_t UdpDoubleSender::sendPreviewAutoSeq(const double* current, int count,
+                                           const double* previews, const uint32_t* offsetsNanos, int horizon) {
+    return sendPreviewWithSeq(current, count, previews, offsetsNanos, horizon,
+                              seq_.fetch_add(1, std::memory_order_relaxed));
+}
+
+size_t UdpDoubleSender::sendPreviewWithSeq(const double* current, int count,
+                                           const double* previews, const uint32_t* offsetsNanos, int horizon,
+                                           int32_t seq, int64_t timestampNanos) {
+    if (!current) throw std::invalid_argument("data is null");
+    if (horizon < 0 || horizon > MAX_PREVIEW_POINTS) throw std::invalid_argument("preview horizon out of range");
+    if (horizon > 0 && (!previews || !offsetsNanos)) throw std::invalid_argument("preview is null");
+    for (int k = 0; k < horizon; ++k) {
+        if (offsetsNanos[k] == 0 || (k > 0 && offsetsNanos[k] <= offsetsNanos[k - 1]))
+            throw std::invalid_argument("preview offsets must be > 0 and increasing");
+    }
+    if (horizon == 0 || !previewAllowed_) return sendWithSeq(current, count, seq, timestampNanos);
+
+    if (count <= 0) return 0;
+    if (count > maxDoubles_.load(std::memory_order_relaxed)) throw std::invalid_argument("count > maxDoubles/payload cap");
+    if (!isOpen_()) throw std::runtime_error("socket not open");
+
+    const size_t fullBytes = (size_t)HEADER_BYTES + (size_t)count * 8;
+    const size_t bytes = fullBytes + 4 + (size_t)horizon * 4 + (size_t)horizon * (size_t)count * 4;
+    if (bytes > (size_t)maxFrameBytes_.load(std::memory_order_relaxed)) throw std::invalid_argument("preview frame > payload cap");
+
+    if (timestampNanos == INT64_MIN) {
+        timestampNanos = monotonicNowNanosNonNegative_();
+    }
+
+    thread_local std::vector<uint8_t> tlsBuffer;
+    if (tlsBuffer.size() < bytes) tlsBuffer.resize(bytes);
+    uint8_t* buf = tlsBuffer.data();
+
+    writeHeader_(buf, MAGIC_PREVIEW, (uint16_t)count, seq, timestampNanos);
+    uint8_t* p = buf + HEADER_BYTES;
+    for (int i = 0; i < count; ++i, p += 8) writeWireDouble_(p, current[i]);
+
+    writeWire16_(p, (uint16_t)horizon);
+    writeWire16_(p + 2, 0);
+    p += 4;
+    for (int k = 0; k < horizon; ++k, p += 4) writeWire32_(p, offsetsNanos[k]);
+    for (int k = 0; k < horizon; ++k) {
+        const double* row = previews + (size_t)k * (size_t)count;
+        for (int i = 0; i < count; ++i, p += 4) {
+            const float delta = (float)(row[i] - current[i]);
+            uint32_t bits;
+            std::memcpy(&bits, &delta, 4);
+            writeWire32_(p, bits);
+        }
+    }
+
+    // carries a full current setpoint, like a full frame
+    return transmitFullState_(buf, bytes, current, count);
+}
+
+// ---------- apply-at frames ----------
+size_t UdpDoubleSender::sendApplyAtAutoSeq(const double* data, int count, int64_t applyAtLocalNanos) {
+    return sendApplyAtWithSeq(data, count, applyAtLocalNanos, seq_.fetch_add(1, std::memory_order_relaxed));
+}
+
+size_t UdpDoubleSender::sendApplyAtWithSeq(const double* data, int count, int64_t applyAtLocalNanos,
+                                           int32_t seq, int64_t timestampNanos) {
+    if (!data) throw std::invalid_argument("data is null");
+    if (!clockSynced_) throw std::logic_error("apply-at frame before syncClock()");
+    if (!applyAtAllowed_) throw std::runtime_error("peer does not accept apply-at frames");
+    if (count <= 0) return 0;
+    if (count > maxDoubles_.load(std::memory_order_relaxed)) throw std::invalid_argument("count > maxDoubles/payload cap");
+    if (!isOpen_()) throw std::runtime_error("socket not open");
+
+    const size_t fullBytes = (size_t)HEADER_BYTES + (size_t)count * 8;
+    const size_t bytes = fullBytes + 8;
+    if (bytes > (size_t)maxFrameBytes_.load(std::memory_order_relaxed)) throw std::invalid_argument("apply-at frame > payload cap");
+
+    if (timestampNanos == INT64_MIN) {
+        timestampNanos = monotonicNowNanosNonNegative_();
+    }
+
+    thread_local std::vector<uint8_t> tlsBuffer;
+    if (tlsBuffer.size() < bytes) tlsBuffer.resize(bytes);
+    uint8_t* buf = tlsBuffer.data();
+
+    writeHeader_(buf, MAGIC_APPLY_AT, (uint16_t)count, seq, timestampNanos);
+    uint8_t* p = buf + HEADER_BYTES;
+    for (int i = 0; i < count; ++i, p += 8) writeWireDouble_(p, data[i]);
+    writeWire64_(p, (uint64_t)toReceiverTime(applyAtLocalNanos));
+
+    return transmitFullState_(buf, bytes, data, count);
+}
+
+// ---------- clock sync ----------
+bool UdpDoubleSender::syncClock(int samples, int timeoutMs) {
+    if (!isOpen_()) throw std::runtime_error("socket not open");
+
+    using clock = std::chrono::steady_clock;
+    auto now = [] { return SteadyClock::nowNanos(); };
+
+    bool any = false;
+    int64_t bestRtt = INT64_MAX, bestOffset = 0;
+    uint8_t msg[UdpClock::MESSAGE_BYTES];
+    uint8_t reply[256];
+
+    for (int sample = 0; sample < std::max(1, samples); ++sample) {
+        UdpClock ping;
+        ping.nonce = (uint32_t)now() ^ (++helloNonce_ * 0x9E3779B9u);
+        ping.senderNanos = now();
+        UdpClock::encode(msg, UdpClock::MAGIC_SYNC, ping);
+        try {
+            transmit_(msg, sizeof(msg));
+        } catch (const std::exception&) {
+            continue;
+        }
+
+        const auto deadline = clock::now() + std::chrono::milliseconds(timeoutMs);
+        for (;;) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count();
+            if (left <= 0) break;
+
+            int64_t t3 = 0;   // when it came off the socket, not when it was dequeued
+            const size_t got = receiveReply_(Reply::Clock, reply, sizeof(reply), (int)left, &t3);
+            if (got == 0) break;
+
+            UdpClock pong;
+            if (!UdpClock::decode(reply, got, UdpClock::MAGIC_REPLY, pong)) continue;
+            if (pong.nonce != ping.nonce || pong.senderNanos != ping.senderNanos) continue;
+
+            const int64_t rtt = (t3 - ping.senderNanos) - (pong.replyNanos - pong.receiveNanos);
+            if (rtt < bestRtt) {
+                bestRtt = rtt;
+                bestOffset = ((pong.receiveNanos - ping.senderNanos) + (pong.replyNanos - t3)) / 2;
+            }
+            any = true;
+            break;
+        }
+    }
+
+    if (!any) return false;
+    clockOffset_ = bestOffset;
+    clockRtt_ = bestRtt;
+    clockSynced_ = true;
+    return true;
+}
+
+// ---------- capability handshake ----------
+bool UdpDoubleSender::waitReadable_(int timeoutMs) const {
+    fd_set rd;
+    FD_ZERO(&rd);
+    FD_SET(sock_, &rd);
+    timeval tv{};
+    tv.tv_sec = timeoutMs / 1000;
+    tv.tv_usec = (timeoutMs % 1000) * 1000;
+    return ::select((int)sock_ + 1, &rd, nullptr, nullptr, &tv) > 0;
+}
+
+bool UdpDoubleSender::negotiate(int timeoutMs, int attempts) {
+    if (!isOpen_()) throw std::runtime_error("socket not open");
+
+    UdpCapabilities local;
+    local.byteOrders = UdpCapabilities::ORDER_BIG | UdpCapabilities::ORDER_LITTLE;
+    local.elementTypes = UdpCapabilities::ELEM_F64;
+    local.compression = UdpCapabilities::COMP_SPARSE | UdpCapabilities::COMP_PREVIEW | UdpCapabilities::COMP_APPLY_AT;
+    const int maxPayload = maxPayloadBytes_.load(std::memory_order_relaxed);
+    local.maxPayloadBytes = (uint16_t)std::min(maxPayload, 0xFFFF);
+    local.maxChannels = (uint16_t)std::min(std::min(requestedMaxDoubles_, (maxPayload - HEADER_BYTES) / 8), 0xFFFF);
+
+    const uint32_t nonce = (uint32_t)monotonicNowNanosNonNegative_() ^ (++helloNonce_ * 0x9E3779B9u);
+
+    uint8_t msg[UdpCapabilities::MESSAGE_BYTES];
+    uint8_t reply[256];
+
+    for (int attempt = 0; attempt < std::max(1, attempts); ++attempt) {
+        UdpCapabilities::encode(msg, UdpCapabilities::MAGIC_HELLO, nonce, local);
+        try {
+            transmit_(msg, sizeof(msg));
+        } catch (const std::exception&) {
+            continue;   // e.g. ICMP unreachable surfaced on a connected socket
+        }
+
+        using clock = std::chrono::steady_clock;
+        const auto deadline = clock::now() + std::chrono::milliseconds(timeoutMs);
+        for (;;) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count();
+            if (left <= 0) break;
+
+            const size_t got = receiveReply_(Reply::Handshake, reply, sizeof(reply), (int)left, nullptr);
+            if (got == 0) break;
+
+            uint32_t magic = 0, echoed = 0;
+            UdpCapabilities peer;
+            if (!UdpCapabilities::decode(reply, got, magic, echoed, peer)) continue;
+            if (magic != UdpCapabilities::MAGIC_ACK || echoed != nonce) continue;
+
+            if (peer.chosenVersion == 0) {
+                std::cerr << "Handshake with " << remoteHost_ << ":" << remotePort_
+                          << ": no compatible encoding, keeping defaults\n";
+                negotiated_ = false;
+                return false;
+            }
+
+            wireLittle_ = (peer.chosenOrder == UdpCapabilities::ORDER_LITTLE);
+            sparseAllowed_ = (peer.chosenCompression & UdpCapabilities::COMP_SPARSE) != 0;
+            previewAllowed_ = (peer.chosenCompression & UdpCapabilities::COMP_PREVIEW) != 0;
+            applyAtAllowed_ = (peer.chosenCompression & UdpCapabilities::COMP_APPLY_AT) != 0;
+            {
+                std::lock_guard<std::mutex> lock(limitsMutex_);
+                peerMaxPayload_ = peer.maxPayloadBytes;
+                peerMaxChannels_ = peer.maxChannels;
+                recomputeLimits_();
+            }
+            lastSentCount_ = 0;   // force a full frame in the new encoding
+            negotiated_ = true;
+
+            if (auth_ && peer.challenge != 0) {
+                // new session: the receiver restarts our replay window here,
+                // even if our clock went backwards (reboot)
+                uint8_t session[UdpAuth::SESSION_BYTES];
+                UdpAuth::encodeSession(session, nonce, (uint64_t)monotonicNowNanosNonNegative_(), peer.challenge);
+                try {
+                    transmit_(session, sizeof(session));
+                } catch (const std::exception&) {
+                    // lost like any datagram: the window restarts on its own once frames overtake it
+                }
+            }
+
+            std::cout << "Handshake with " << remoteHost_ << ":" << remotePort_
+                      << " -> version=" << int(peer.chosenVersion)
+                      << " order=" << UdpCapabilities::orderName(peer.chosenOrder)
+                      << " sparse=" << (sparseAllowed_ ? "yes" : "no")
+                      << " preview=" << (previewAllowed_ ? "yes" : "no")
+                      << " applyAt=" << (applyAtAllowed_ ? "yes" : "no")
+                      << " maxDoubles=" << getMaxDoubles() << "\n";
+            return true;
+        }
+    }
+
+    std::cerr << "Handshake with " << remoteHost_ << ":" << remotePort_
+              << ": no reply, keeping " << (wireLittle_ ? "LITTLE" : "BIG") << " encoding\n";
+    negotiated_ = false;
+    return false;
+}
+
+// ---------- receiver reports ----------
+bool UdpDoubleSender::pollReport(UdpReport& out) {
+    if (!isOpen_()) return false;
+
+    uint8_t msg[256];
+    while (const size_t got = receiveReply_(Reply::Report, msg, sizeof(msg), 0, nullptr)) {
+        if (UdpReport::decode(msg, got, out)) return true;
+    }
+    return false;
+}
+
+size_t UdpDoubleSender::sendDatagram(const uint8_t* buf, size_t bytes) {
+    if (!isOpen_()) throw std::runtime_error("socket not open");
+    return transmit_(buf, bytes);
+}
+
+size_t UdpDoubleSender::receiveDatagram(Reply kind, uint8_t* buf, size_t capacity, int timeoutMs) {
+    if (!isOpen_()) return 0;
+    return receiveReply_(kind, buf, capacity, std::max(0, timeoutMs), nullptr);
+}
+
+size_t UdpDoubleSender::receiveReply_(Reply kind, uint8_t* buf, size_t capacity, int timeoutMs, int64_t* receivedNanos) {
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() + std::chrono::milliseconds(timeoutMs);
+    auto& queue = replies_->queues[(size_t)kind];
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(replies_->mtx);
+            routePendingReplies_();
+            if (!queue.empty()) {
+                const ReplyQueues::Item& item = queue.front();
+                const size_t n = std::min(capacity, item.bytes.size());
+                std::memcpy(buf, item.bytes.data(), n);
+                if (receivedNanos) *receivedNanos = item.receivedNanos;
+                queue.pop_front();
+                return n;
+            }
+        }
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count();
+        if (left <= 0) return 0;
+        // short waits: another caller may route our reply while we sleep
+        waitReadable_((int)std::min<int64_t>(left, 1));
+    }
+}
+
+void UdpDoubleSender::routePendingReplies_() {
+    uint8_t msg[2048];
+    while (waitReadable_(0)) {
+        sockaddr_storage from{};
+        socklen_t fromLen = (socklen_t)sizeof(from);
+        int got = ::recvfrom(sock_, (char*)msg, (int)sizeof(msg), 0, (sockaddr*)&from, &fromLen);
+        const int64_t t = SteadyClock::nowNanos();
+        if (got <= 0) return;   // e.g. ICMP unreachable on a connected socket
+        if (!authenticReply_(msg, got)) continue;   // forged
+
+        auto& queue = replies_->queues[(size_t)ReplyQueues::kindOf(msg, (size_t)got)];
+        if (queue.size() >= MAX_QUEUED_REPLIES) queue.pop_front();
+        queue.push_back(ReplyQueues::Item{std::vector<uint8_t>(msg, msg + got), t});
+    }
+}
+
+// ---------- authentication ----------
+void UdpDoubleSender::setAuthKey(const uint8_t* key) {
+    auth_.reset(key ? new UdpAuth(key) : nullptr);
+    std::lock_guard<std::mutex> lock(limitsMutex_);
+    recomputeLimits_();
+}
 
-    return (size_t)sent;
+bool UdpDoubleSender::authenticReply_(const uint8_t* buf, int& got) const {
+    if (!auth_) return true;
+    if (!auth_->verify(buf, (size_t)got)) return false;
+    got -= (int)UdpAuth::TAG_BYTES;
+    return true;
 }
 
 void UdpDoubleSender::close() { closeSock_(); }
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -10,9 +13,14 @@
   #endif
   #include <winsock2.h>
   #include <ws2tcpip.h>
+#else
+  #include <sys/socket.h>
+  #include <netinet/in.h>
 #endif
 
 
+struct UdpReport;
+class UdpAuth;
 
 class UdpDoubleSender {
 public:
@@ -20,6 +28,10 @@ public:
 
     // Interop constants (match Java)
     static constexpr uint32_t MAGIC = 0x55445044u; // "UDPD"
+    static constexpr uint32_t MAGIC_SPARSE = 0x55445053u; // "UDPS": bitmap + changed values
+    static constexpr uint32_t MAGIC_PREVIEW = 0x55445054u; // "UDPT": setpoint + planned setpoints
+    static constexpr int MAX_PREVIEW_POINTS = 255;
+    static constexpr uint32_t MAGIC_APPLY_AT = 0x55445045u; // "UDPE": full frame + apply-at time
     static constexpr uint16_t VERSION = 1;
     static constexpr int HEADER_BYTES = 20;
     static constexpr int DEFAULT_MAX_UDP_PAYLOAD = 1400;
@@ -31,7 +43,8 @@ public:
                      bool connectUdp = true,
                      int maxPayloadBytes = DEFAULT_MAX_UDP_PAYLOAD,
                      IpMode ipMode = IpMode::Any,
-                     int requestedSndBuf = 128 * 1024);
+                     int requestedSndBuf = 128 * 1024,
+                     bool resolveInBackground = false);
 
     // Move-only
     UdpDoubleSender(const UdpDoubleSender&) = delete;
@@ -45,6 +58,39 @@ public:
     int  getMaxDoubles() const;
     int  getSendBufferBytes() const;
 
+    // Destination resolution. With resolveInBackground the constructor does
+    // not call getaddrinfo: the socket is created for the ipMode family
+    // (Any -> IPv4) and a resolver thread fills in the address; sends before
+    // that return 0. Re-resolution (periodic or triggered) swaps the
+    // destination atomically; the send path only reads it (seqlock, no lock).
+    struct ResolveStats {
+        bool resolved = false;
+        uint64_t attempts = 0;
+        uint64_t failures = 0;
+        uint64_t swaps = 0;              // destination changed
+        uint64_t unresolvedDrops = 0;    // sends before the first resolution
+        int64_t lastLatencyNanos = 0;
+        int64_t maxLatencyNanos = 0;
+        std::string lastError;
+    };
+    void setDestination(const std::string& remoteHost, uint16_t remotePort);
+    void requestResolve();
+    void setReresolveInterval(int intervalMs);   // <= 0: only on request
+    bool isResolved() const;
+    ResolveStats getResolveStats() const;
+
+    // Path MTU discovery. Sets Don't-Fragment on the socket, optionally sends
+    // one DF probe datagram ("UDPP", ignored by receivers) and reads the
+    // kernel's path MTU for the destination (IP_MTU / IPV6_MTU, connected
+    // sockets only). The resulting payload limit replaces maxPayloadBytes,
+    // so jumbo-frame paths can carry up to the constructor's maxDoubles and
+    // VPN paths shrink to avoid IP fragmentation. Re-run automatically when a
+    // send fails with EMSGSIZE. Returns the effective max payload (0 if the
+    // platform/socket cannot report a path MTU; limits are then unchanged).
+    int  probePathMtu(bool sendProbe = true);
+    int  getPathMtu() const { return pathMtu_.load(std::memory_order_relaxed); }
+    int  getEffectiveMaxPayload() const;
+
     // TTL / hop limit
     void setUnicastHopLimit(int hops);
     void setMulticastHopLimit(int hops);
@@ -54,10 +100,117 @@ public:
     void setMulticastInterfaceIPv4(uint32_t ifAddrNbo);
     void setMulticastInterfaceIPv6(unsigned int ifIndex);
 
-    // Sending
+    // Sending. sendAutoSeq / sendWithSeq may be called from several threads
+    // at once: seq comes from an atomic counter, each thread encodes into its
+    // own buffer and datagrams go to the socket without a lock. negotiate()
+    // and the setters are single-producer (configure first).
+    //
+    // Sparse sends serialise on one lock. Once the first one was sent, full,
+    // preview and apply-at frames take that lock too (they reset the sparse
+    // baseline), so wire order and baseline always agree; senders that never
+    // send sparse frames stay lock-free.
     size_t sendAutoSeq(const double* data, int count);
     size_t sendWithSeq(const double* data, int count, int32_t seq, int64_t timestampNanos = INT64_MIN);
 
+    // Sparse updates: only channels whose change since the last transmitted
+    // value exceeds their deadband are sent (header + change bitmap + values).
+    // A full frame goes out every fullRefreshInterval frames, on count
+    // change, or whenever it would not be larger than the sparse one.
+    void   setDeadbands(const double* deadbands, int count); // missing channels: 0 (any change)
+    void   setFullRefreshInterval(int frames);                // <= 1: always full
+    size_t sendSparseAutoSeq(const double* data, int count);
+    size_t sendSparseWithSeq(const double* data, int count, int32_t seq, int64_t timestampNanos = INT64_MIN);
+
+    // Trajectory preview ("UDPT"): the current setpoint plus `horizon`
+    // planned setpoints, row k (count doubles in previews[k * count..]) due
+    // offsetsNanos[k] after this frame (> 0, increasing). Planned rows go
+    // out as float deltas against the current setpoint:
+    //
+    //   [20..20+8n)  current setpoint (as in a full frame)
+    //   u16 horizon, u16 reserved, u32 offsetNanos[horizon],
+    //   f32 delta[horizon][n]
+    //
+    // The receiver follows the preview while frames are missing (see
+    // UdpDoubleReceiver::getSetpointAt). Throws if the frame exceeds the
+    // payload limit; a peer that declined previews in negotiate() gets a
+    // full frame of the current setpoint.
+    size_t sendPreviewAutoSeq(const double* current, int count,
+                              const double* previews, const uint32_t* offsetsNanos, int horizon);
+    size_t sendPreviewWithSeq(const double* current, int count,
+                              const double* previews, const uint32_t* offsetsNanos, int horizon,
+                              int32_t seq, int64_t timestampNanos = INT64_MIN);
+
+    // Clock offset to the receiver (UdpClock.hpp) from `samples` round
+    // trips, keeping the one with the shortest round trip. False if no
+    // reply arrived (the previous estimate is kept). The error is at most
+    // half that round trip; a receiver polling with WaitStrategy Sleep
+    // answers late and widens it, Block or spinning ones answer at once.
+    // Repeat now and then: the two steady_clocks drift apart by tens of ppm.
+    bool    syncClock(int samples = 8, int timeoutMs = 100);
+    bool    isClockSynced() const { return clockSynced_; }
+    int64_t getClockOffsetNanos() const { return clockOffset_; }   // receiver - local
+    int64_t getClockRttNanos() const { return clockRtt_; }         // of the sample used
+    // Local steady_clock nanos -> receiver steady_clock nanos.
+    int64_t toReceiverTime(int64_t localNanos) const { return localNanos + clockOffset_; }
+
+    // Apply-at frames ("UDPE"): a full frame plus the instant it takes
+    // effect, given on the local steady_clock and sent as receiver time:
+    //
+    //   [20..20+8n)  payload (as in a full frame)
+    //   i64          apply-at, receiver steady_clock nanos
+    //
+    // The receiver holds the frame until then (see
+    // UdpDoubleReceiver::setReleaseQueue), so frames sent to several
+    // receivers for the same instant take effect together, up to each
+    // clock estimate's error. Throws unless syncClock() succeeded, or if
+    // the peer declined apply-at frames in negotiate().
+    size_t sendApplyAtAutoSeq(const double* data, int count, int64_t applyAtLocalNanos);
+    size_t sendApplyAtWithSeq(const double* data, int count, int64_t applyAtLocalNanos,
+                              int32_t seq, int64_t timestampNanos = INT64_MIN);
+
+    // Capability handshake (see UdpCapabilities.hpp): sends HELLO and waits
+    // for the receiver's ACK, then switches to the chosen byte order,
+    // enables/disables sparse frames and clamps maxDoubles to the agreed
+    // limits. With authentication it also answers the receiver's session
+    // challenge, restarting this sender's replay window there (needed after
+    // a reboot, when timestamps start lower). Call at start and again after
+    // reconnecting. Returns false (keeping the current encoding) if no
+    // compatible answer arrives.
+    bool negotiate(int timeoutMs = 200, int attempts = 3);
+    bool isNegotiated() const { return negotiated_; }
+    bool isWireLittleEndian() const { return wireLittle_; }
+
+    // Receiver reports (see UdpReport.hpp) sent back on this socket.
+    // Non-blocking: false when none is pending.
+    bool pollReport(UdpReport& out);
+
+    // Per-datagram authentication (see UdpAuth.hpp) with a 16-byte key
+    // shared with the receiver; nullptr turns it off. Every datagram then
+    // carries an 8-byte tag (maxDoubles shrinks by one) and replies without
+    // a valid tag are dropped. Configure before sending.
+    void setAuthKey(const uint8_t* key);
+    bool isAuthenticated() const { return auth_ != nullptr; }
+
+    // Replies on this socket are demultiplexed by magic: whichever caller
+    // reads the socket routes every datagram into the queue of its kind
+    // (MAX_QUEUED_REPLIES each, oldest dropped), so negotiate(),
+    // syncClock(), pollReport() and a BulkSender can run on different
+    // threads without eating each other's replies.
+    enum class Reply : uint8_t {
+        Handshake,   // UDPA
+        Clock,       // UDPY
+        Report,      // UDPR
+        BulkAck,     // UDPK
+        Other,
+    };
+    static constexpr size_t MAX_QUEUED_REPLIES = 64;
+
+    // Raw datagrams for protocols layered on this socket (BulkSender).
+    // receiveDatagram waits up to timeoutMs (0: poll) for a reply of the
+    // given kind and returns its byte count, 0 on timeout.
+    size_t sendDatagram(const uint8_t* buf, size_t bytes);
+    size_t receiveDatagram(Reply kind, uint8_t* buf, size_t capacity, int timeoutMs);
+
     void close();
 
 private:
@@ -69,22 +222,60 @@ private:
     int sock_ = -1;
 #endif
 
+    struct Destination;
+    struct ReplyQueues;
+    std::unique_ptr<Destination> dest_;
+    std::unique_ptr<ReplyQueues> replies_;
+
     std::string remoteHost_;
     uint16_t remotePort_ = 0;
     bool connect_ = false;
     IpMode ipMode_ = IpMode::Any;
 
     int family_ = 0;
-    sockaddr_storage destAddr_{};
-    socklen_t destAddrLen_ = 0;
 
-    int maxDoubles_ = 0;
-    int32_t seq_ = 0;
+    std::atomic<int> maxDoubles_{0};
+    std::atomic<int32_t> seq_{0};
+
+    std::vector<uint8_t> buffer_;   // sparse frames; sized once for requestedMaxDoubles_
 
-    std::vector<uint8_t> buffer_;
+    // sparse mode state: what the receiver currently holds (sparseMutex_)
+    std::mutex sparseMutex_;
+    std::atomic<bool> sparseActive_{false};   // a sparse frame was sent
+    std::vector<double> deadbands_;
+    std::vector<double> lastSent_;
+    int lastSentCount_ = 0;
+    int fullRefreshInterval_ = 50;
+    int framesSinceFull_ = 0;
 
     int64_t tsOffset_ = 0; // to avoid negative steady_clock nanos
 
+    // payload / channel limits: maxDoubles_ = min(requested, payload, peer caps).
+    // Producers read the atomics; every change (probe, negotiate, auth key,
+    // an EMSGSIZE re-probe on any producer thread) holds limitsMutex_.
+    std::mutex limitsMutex_;
+    int  requestedMaxDoubles_ = 0;
+    std::atomic<int> pathMtu_{0};
+    int  peerMaxPayload_ = 0;     // from negotiate(), 0 = unknown
+    int  peerMaxChannels_ = 0;
+    std::atomic<int> maxFrameBytes_{0};   // datagram limit before the auth tag
+
+    // negotiated encoding (defaults: BE, full + sparse + preview frames)
+    std::atomic<int> maxPayloadBytes_{DEFAULT_MAX_UDP_PAYLOAD};
+    bool wireLittle_ = false;
+    bool sparseAllowed_ = true;
+    bool previewAllowed_ = true;
+    bool applyAtAllowed_ = true;
+    bool negotiated_ = false;
+    uint32_t helloNonce_ = 0;
+
+    std::unique_ptr<UdpAuth> auth_;   // null: datagrams go out untagged
+
+    // receiver clock estimate (syncClock)
+    bool    clockSynced_ = false;
+    int64_t clockOffset_ = 0;
+    int64_t clockRtt_ = 0;
+
 private:
     bool   isOpen_() const;
     void   closeSock_();
@@ -93,10 +284,24 @@ private:
     void   initTimestampOffset_();
     int64_t monotonicNowNanosNonNegative_() const;
 
+    size_t transmit_(const uint8_t* buf, size_t bytes);
+    // Checks and strips the tag of a received datagram (no-op without a key).
+    bool   authenticReply_(const uint8_t* buf, int& got) const;
+    // Encodes a full frame into buf; returns its size.
+    size_t encodeFull_(uint8_t* buf, const double* data, int count, int32_t seq, int64_t timestampNanos) const;
+    // Sends a frame carrying the whole state (full, preview, apply-at) and
+    // rebases the sparse baseline on it while sparse sends are in use.
+    size_t transmitFullState_(const uint8_t* buf, size_t bytes, const double* data, int count);
+    void   rebaseSparse_(const double* data, int count);
+    static bool changed_(double now, double last, double deadband);
+
     static int desiredFamily_(IpMode m);
     static std::string lastSockErr_();
 
     void   createAndConfigureSocket_(uint16_t localPort, int requestedSndBuf);
+    void   createUnresolvedSocket_(uint16_t localPort, int requestedSndBuf);
+    void   startResolver_();
+    void   stopResolver_();
     static bool bindLocal_(decltype(sock_) s, int family, uint16_t localPort);
 
     // endian / packing helpers
@@ -109,4 +314,22 @@ private:
     static void writeBE32_fromBits_(uint8_t* dst, int32_t s);
     static void writeBE64_fromBits_(uint8_t* dst, int64_t s);
     static void writeDoubleBE_(uint8_t* dst, double d);
+
+    // wire-order writers (BE or LE per wireLittle_)
+    void writeWire16_(uint8_t* dst, uint16_t v) const;
+    void writeWire32_(uint8_t* dst, uint32_t v) const;
+    void writeWire64_(uint8_t* dst, uint64_t v) const;
+    void writeWireDouble_(uint8_t* dst, double d) const;
+    void writeHeader_(uint8_t* dst, uint32_t magic, uint16_t count, int32_t seq, int64_t timestampNanos) const;
+
+    bool waitReadable_(int timeoutMs) const;
+    // Next reply of one kind (see Reply); receivedNanos is the steady_clock
+    // time it was read off the socket.
+    size_t receiveReply_(Reply kind, uint8_t* buf, size_t capacity, int timeoutMs, int64_t* receivedNanos);
+    void   routePendingReplies_();   // replies_->mtx held
+
+    void recomputeLimits_();   // limitsMutex_ held (or constructing)
+    bool setDontFragment_();
+    int  readPathMtu_() const;
+    static bool lastErrorIsMsgSize_();
 };
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "UdpWire.hpp"
+
+// Receiver report ("UDPR"), sent by UdpDoubleReceiver back to each sender
+// endpoint every report interval (see enableReports). Always big-endian,
+// count = 0, header seq = report number, ts = receiver steady_clock nanos:
+//
+//   [0..19]  standard UDPD header
+//   [20..23] highestSeq      [24..27] received (cumulative, wraps)
+//   [28..31] lost            [32..35] lateOrDuplicate
+//   [36..39] jitterMicros    [40..41] pressurePermille
+//   [42..43] intervalMillis  [44..47] overwritten (published, never read)
+//
+// Peers that do not know this magic (e.g. the Java side) just drop it.
+struct UdpReport {
+    static constexpr std::uint32_t MAGIC_REPORT = 0x55445052u; // "UDPR"
+    static constexpr std::size_t   HEADER_BYTES = 20;
+    static constexpr std::size_t   MESSAGE_BYTES = HEADER_BYTES + 28;
+
+    std::uint32_t reportSeq = 0;
+    std::uint64_t receiverNanos = 0;
+    std::uint32_t highestSeq = 0;
+    std::uint32_t received = 0;
+    std::uint32_t lost = 0;
+    std::uint32_t lateOrDuplicate = 0;
+    std::uint32_t jitterMicros = 0;        // RFC 3550 style interarrival jitter
+    std::uint16_t pressurePermille = 0;    // receiver-side queue fill, 0..1000
+    std::uint16_t intervalMillis = 0;
+    std::uint32_t overwritten = 0;
+
+    static void encode(std::uint8_t* dst, const UdpReport& r) {
+        UdpWire::put32(dst + 0, MAGIC_REPORT);
+        UdpWire::put16(dst + 4, 1);
+        UdpWire::put16(dst + 6, 0);
+        UdpWire::put32(dst + 8, r.reportSeq);
+        UdpWire::put32(dst + 12, std::uint32_t(r.receiverNanos >> 32));
+        UdpWire::put32(dst + 16, std::uint32_t(r.receiverNanos));
+
+        std::uint8_t* p = dst + HEADER_BYTES;
+        UdpWire::put32(p + 0, r.highestSeq);
+        UdpWire::put32(p + 4, r.received);
+        UdpWire::put32(p + 8, r.lost);
+        UdpWire::put32(p + 12, r.lateOrDuplicate);
+        UdpWire::put32(p + 16, r.jitterMicros);
+        UdpWire::put16(p + 20, r.pressurePermille);
+        UdpWire::put16(p + 22, r.intervalMillis);
+        UdpWire::put32(p + 24, r.overwritten);
+    }
+
+    // Returns false unless p holds a report.
+    static bool decode(const std::uint8_t* p, std::size_t n, UdpReport& r) {
+        if (n < MESSAGE_BYTES || UdpWire::get32(p) != MAGIC_REPORT) return false;
+        r.reportSeq = UdpWire::get32(p + 8);
+        r.receiverNanos = (std::uint64_t(UdpWire::get32(p + 12)) << 32) | UdpWire::get32(p + 16);
+
+        const std::uint8_t* q = p + HEADER_BYTES;
+        r.highestSeq = UdpWire::get32(q + 0);
+        r.received = UdpWire::get32(q + 4);
+        r.lost = UdpWire::get32(q + 8);
+        r.lateOrDuplicate = UdpWire::get32(q + 12);
+        r.jitterMicros = UdpWire::get32(q + 16);
+        r.pressurePermille = UdpWire::get16(q + 20);
+        r.intervalMillis = UdpWire::get16(q + 22);
+        r.overwritten = UdpWire::get32(q + 24);
+        return true;
+    }
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+// Big-endian field access for the control messages (UdpCapabilities,
+// UdpReport, UdpClock, UdpBulk) and the trace files. Unaligned-safe.
+struct UdpWire {
+    static void put16(std::uint8_t* d, std::uint16_t v) { d[0] = std::uint8_t(v >> 8); d[1] = std::uint8_t(v); }
+    static void put32(std::uint8_t* d, std::uint32_t v) {
+        d[0] = std::uint8_t(v >> 24); d[1] = std::uint8_t(v >> 16); d[2] = std::uint8_t(v >> 8); d[3] = std::uint8_t(v);
+    }
+    static void put64(std::uint8_t* d, std::uint64_t v) { put32(d, std::uint32_t(v >> 32)); put32(d + 4, std::uint32_t(v)); }
+
+    static std::uint16_t get16(const std::uint8_t* p) { return std::uint16_t((p[0] << 8) | p[1]); }
+    static std::uint32_t get32(const std::uint8_t* p) {
+        return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | std::uint32_t(p[3]);
+    }
+    static std::uint64_t get64(const std::uint8_t* p) { return (std::uint64_t(get32(p)) << 32) | get32(p + 4); }
+};
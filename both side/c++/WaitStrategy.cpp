@@ -0,0 +1,82 @@
+#include "WaitStrategy.hpp"
+
+#include <algorithm>
+
+static constexpr double SPIN_FILTER = 1.0 / 8.0;   // EWMA weight of one wait
+static constexpr double SPIN_HEADROOM = 2.0;       // budget = headroom x typical useful spin
+
+WaitStrategy::WaitStrategy()
+    : WaitStrategy(Config())
+{
+}
+
+WaitStrategy::WaitStrategy(const Config& cfg)
+    : cfg_(cfg),
+      budget_(std::max<std::int64_t>(0, cfg.spinNanos)),
+      avgSpin_((double)budget_ / SPIN_HEADROOM)
+{
+    budgetSeen_.store(budget_, std::memory_order_relaxed);
+}
+
+// ---------- presets ----------
+WaitStrategy::Config WaitStrategy::sleep(std::int64_t sleepNanos) {
+    Config c;
+    c.kind = Kind::Sleep;
+    c.sleepNanos = sleepNanos;
+    return c;
+}
+
+WaitStrategy::Config WaitStrategy::block() {
+    Config c;
+    c.kind = Kind::Block;
+    return c;
+}
+
+WaitStrategy::Config WaitStrategy::spin() {
+    Config c;
+    c.kind = Kind::Spin;
+    return c;
+}
+
+WaitStrategy::Config WaitStrategy::yield() {
+    Config c;
+    c.kind = Kind::Yield;
+    return c;
+}
+
+WaitStrategy::Config WaitStrategy::spinThenBlock(std::int64_t spinNanos, bool adaptive) {
+    Config c;
+    c.kind = Kind::SpinThenBlock;
+    c.spinNanos = spinNanos;
+    c.adaptive = adaptive;
+    return c;
+}
+
+// ---------- learning ----------
+void WaitStrategy::done() {
+    const std::int64_t waited = nowNanos() - started_;
+    bump(waits_);
+    if (!blocked_) bump(spinHits_);
+    bump(waitSum_, waited);
+
+    if (cfg_.kind != Kind::SpinThenBlock || !cfg_.adaptive) return;
+
+    // How long spinning would have had to last to catch this wait. Waits
+    // beyond maxSpinNanos were out of reach: count them as "do not spin".
+    const double useful = (waited <= cfg_.maxSpinNanos) ? (double)waited : 0.0;
+    avgSpin_ += (useful - avgSpin_) * SPIN_FILTER;
+    budget_ = std::min<std::int64_t>(cfg_.maxSpinNanos,
+                                     std::max<std::int64_t>(cfg_.minSpinNanos, (std::int64_t)(avgSpin_ * SPIN_HEADROOM)));
+    budgetSeen_.store(budget_, std::memory_order_relaxed);
+}
+
+WaitStrategy::Stats WaitStrategy::stats() const {
+    Stats s;
+    s.waits = waits_.load(std::memory_order_relaxed);
+    s.spinHits = spinHits_.load(std::memory_order_relaxed);
+    s.blocks = blocks_.load(std::memory_order_relaxed);
+    s.timeouts = timeouts_.load(std::memory_order_relaxed);
+    s.meanWaitNanos = s.waits ? (double)waitSum_.load(std::memory_order_relaxed) / (double)s.waits : 0.0;
+    s.spinBudgetNanos = budgetSeen_.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "Simd.hpp"
+#include "SteadyClock.hpp"
+
+// How a thread waits for the next frame: a latency / CPU trade-off.
+//
+// - Sleep:          poll, sleeping sleepNanos between checks (the old
+//                   fixed 2 ms receiver poll)
+// - Block:          sleep in the kernel until woken (socket readable,
+//                   frame published); no CPU while idle
+// - Spin:           re-check in a tight loop; lowest latency, one full core
+// - Yield:          re-check, yielding the core to other runnable threads
+// - SpinThenBlock:  spin for a budget, then block. With adaptive the
+//                   budget is learned: waits that end shortly after the
+//                   budget grow it, waits much longer than maxSpinNanos
+//                   (spinning would not have helped) shrink it.
+//
+// One WaitStrategy per waiting thread (it keeps the learned budget);
+// stats() may be read from any thread. A wait is begin(), idle() after
+// every failed check, then done() once satisfied; wait() wraps that for a
+// ready predicate.
+class WaitStrategy {
+public:
+    enum class Kind { Sleep, Block, Spin, Yield, SpinThenBlock };
+
+    struct Config {
+        Kind kind = Kind::Sleep;
+        std::int64_t sleepNanos = 2'000'000;   // Sleep: poll period
+        std::int64_t spinNanos = 20'000;       // SpinThenBlock: (initial) budget
+        bool adaptive = true;                  // SpinThenBlock: learn the budget
+        std::int64_t minSpinNanos = 1'000;     // adaptive bounds
+        std::int64_t maxSpinNanos = 200'000;
+    };
+
+    struct Stats {
+        std::uint64_t waits = 0;               // completed waits
+        std::uint64_t spinHits = 0;            // satisfied before blocking / sleeping
+        std::uint64_t blocks = 0;              // block / sleep calls
+        std::uint64_t timeouts = 0;            // wait() deadline passed
+        double meanWaitNanos = 0.0;            // begin() -> done()
+        std::int64_t spinBudgetNanos = 0;      // current budget
+    };
+
+    WaitStrategy();
+    explicit WaitStrategy(const Config& cfg);
+
+    // Presets
+    static Config sleep(std::int64_t sleepNanos = 2'000'000);
+    static Config block();
+    static Config spin();
+    static Config yield();
+    static Config spinThenBlock(std::int64_t spinNanos = 20'000, bool adaptive = true);
+
+    const Config& config() const { return cfg_; }
+    Kind kind() const { return cfg_.kind; }
+    Stats stats() const;
+
+    void begin() {
+        started_ = nowNanos();
+        blocked_ = false;
+    }
+
+    // One failed check. block(untilNanos) must return once the condition
+    // may have changed or untilNanos passed (early returns are fine).
+    template <typename Block>
+    void idle(Block&& block, std::int64_t untilNanos) {
+        switch (cfg_.kind) {
+        case Kind::Spin:
+            pause();
+            return;
+        case Kind::Yield:
+            std::this_thread::yield();
+            return;
+        case Kind::SpinThenBlock:
+            if (nowNanos() - started_ < budget_) {
+                pause();
+                return;
+            }
+            break;
+        case Kind::Sleep: {
+            blocked_ = true;
+            bump(blocks_);
+            const std::int64_t now = nowNanos();
+            const std::int64_t until = (untilNanos < now + cfg_.sleepNanos) ? untilNanos : now + cfg_.sleepNanos;
+            if (until > now) std::this_thread::sleep_for(std::chrono::nanoseconds(until - now));
+            return;
+        }
+        case Kind::Block:
+            break;
+        }
+        blocked_ = true;
+        bump(blocks_);
+        block(untilNanos);
+    }
+
+    void done();
+
+    // Waits until ready() or deadlineNanos; returns ready().
+    template <typename Ready, typename Block>
+    bool wait(Ready&& ready, Block&& block, std::int64_t deadlineNanos) {
+        if (ready()) {
+            bump(waits_);
+            bump(spinHits_);
+            return true;
+        }
+        begin();
+        for (;;) {
+            if (nowNanos() >= deadlineNanos) {
+                bump(timeouts_);
+                return ready();
+            }
+            idle(block, deadlineNanos);
+            if (ready()) {
+                done();
+                return true;
+            }
+        }
+    }
+
+    static std::int64_t nowNanos() { return SteadyClock::nowNanos(); }
+
+private:
+    static void pause() {
+#if SIMD_SSE2
+        _mm_pause();   // eases the sibling hyper-thread and the memory bus
+#endif
+    }
+
+    // single writer: no locked read-modify-write needed
+    template <typename T>
+    static void bump(std::atomic<T>& v, T by = 1) { v.store(v.load(std::memory_order_relaxed) + by, std::memory_order_relaxed); }
+
+private:
+    const Config cfg_;
+    std::int64_t budget_ = 0;
+    double avgSpin_ = 0.0;                 // adaptive: EWMA of useful spin time
+    std::int64_t started_ = 0;
+    bool blocked_ = false;
+
+    std::atomic<std::uint64_t> waits_{0};
+    std::atomic<std::uint64_t> spinHits_{0};
+    std::atomic<std::uint64_t> blocks_{0};
+    std::atomic<std::uint64_t> timeouts_{0};
+    std::atomic<std::int64_t>  waitSum_{0};
+    std::atomic<std::int64_t>  budgetSeen_{0};
+};
@@ -0,0 +1,74 @@
+// Multi-producer send benchmark for UdpDoubleSender.
+//
+// N producer threads share one sender and each push FRAMES_PER_THREAD frames
+// of CHANNELS doubles. "mutex" serialises every send behind one lock (the
+// old workaround), "concurrent" uses the lock-free send path directly and
+// "mixed" has every other thread send sparse frames while the rest send full
+// ones (both then share the sparse lock). Frames go to an unconnected
+// loopback port, so nobody needs to listen.
+//
+// Race check: build with -fsanitize=thread (gcc/clang) and run; the "mixed"
+// rows exercise the sparse baseline against concurrent full sends.
+
+#include "UdpDoubleSender.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+int main() {
+    // ---- CONFIG ----
+    const std::string destIp = "127.0.0.1";
+    const uint16_t destPort = 39999;
+    const int channels = 172;
+    const int framesPerThread = 50000;
+    const int maxThreads = 8;
+    // ----------------
+
+    std::printf("%-8s %-11s %12s %12s\n", "threads", "mode", "frames/s", "ns/frame");
+
+    const char* modeNames[] = {"mutex", "concurrent", "mixed"};
+    for (int threads = 1; threads <= maxThreads; ++threads) {
+        for (int mode = 0; mode < 3; ++mode) {
+            const bool useMutex = (mode == 0);
+            std::mutex lock;
+            // fresh sender per row: once sparse, full sends take the lock
+            UdpDoubleSender tx(destIp, destPort, 0, channels, false,
+                               UdpDoubleSender::DEFAULT_MAX_UDP_PAYLOAD,
+                               UdpDoubleSender::IpMode::IPv4, 4 * 1024 * 1024);
+
+            auto worker = [&](int id) {
+                const bool sparse = (mode == 2) && (id % 2 == 1);
+                std::vector<double> frame((size_t)channels, (double)id);
+                for (int i = 0; i < framesPerThread; ++i) {
+                    frame[0] = (double)i;
+                    try {
+                        if (useMutex) {
+                            std::lock_guard<std::mutex> g(lock);
+                            tx.sendAutoSeq(frame.data(), channels);
+                        } else if (sparse) {
+                            tx.sendSparseAutoSeq(frame.data(), channels);
+                        } else {
+                            tx.sendAutoSeq(frame.data(), channels);
+                        }
+                    } catch (const std::exception&) {
+                        // transient ENOBUFS on a saturated loopback; keep going
+                    }
+                }
+            };
+
+            const auto t0 = std::chrono::steady_clock::now();
+            std::vector<std::thread> pool;
+            for (int t = 0; t < threads; ++t) pool.emplace_back(worker, t);
+            for (auto& th : pool) th.join();
+            const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+            const double frames = (double)threads * framesPerThread;
+            std::printf("%-8d %-11s %12.0f %12.1f\n", threads, modeNames[mode],
+                        frames / secs, secs * 1e9 / frames);
+        }
+    }
+    return 0;
+}
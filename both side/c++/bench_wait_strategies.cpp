@@ -0,0 +1,123 @@
+// Latency vs. CPU benchmark for the receiver / consumer wait strategies.
+//
+// A sender thread sends one frame every INTERVAL_US over loopback, stamped
+// with its steady_clock send time. The receiver thread waits with the
+// strategy under test; one consumer thread waits for every new frame with
+// waitLatest() and the same kind. Latency is send -> consumer wake-up;
+// CPU is process CPU time over wall time (1.00 = one full core, sender
+// included). "legacy" is the old fixed polling: receiver 2 ms, consumer
+// 10 ms.
+
+#include "UdpDoubleReceiver.hpp"
+#include "UdpDoubleSender.hpp"
+#include "WaitStrategy.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <time.h>
+#endif
+
+static double processCpuSeconds() {
+#if defined(_WIN32)
+    FILETIME created, exited, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user);
+    auto secs = [](const FILETIME& f) {
+        return (double)((std::uint64_t(f.dwHighDateTime) << 32) | f.dwLowDateTime) * 1e-7;
+    };
+    return secs(kernel) + secs(user);
+#else
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+int main() {
+    // ---- CONFIG ----
+    const std::string ip = "127.0.0.1";
+    const int basePort = 39500;
+    const int intervalUs = 1000;
+    const int frames = 3000;
+    // ----------------
+
+    struct Case {
+        const char* name;
+        WaitStrategy::Config receiver;
+        WaitStrategy::Config consumer;
+    };
+    const Case cases[] = {
+        {"legacy",       WaitStrategy::sleep(2'000'000), WaitStrategy::sleep(10'000'000)},
+        {"sleep-100us",  WaitStrategy::sleep(100'000),   WaitStrategy::sleep(100'000)},
+        {"block",        WaitStrategy::block(),          WaitStrategy::block()},
+        {"yield",        WaitStrategy::yield(),          WaitStrategy::yield()},
+        {"spin",         WaitStrategy::spin(),           WaitStrategy::spin()},
+        {"spin50+block", WaitStrategy::spinThenBlock(50'000, false), WaitStrategy::spinThenBlock(50'000, false)},
+        {"adaptive",     WaitStrategy::spinThenBlock(),  WaitStrategy::spinThenBlock()},
+    };
+
+    std::printf("%d frames, one every %d us\n", frames, intervalUs);
+    std::printf("%-13s %9s %9s %9s %9s %7s %8s %10s\n",
+                "strategy", "p50 us", "p99 us", "max us", "missed", "cpu", "rx hits", "rx budget");
+
+    int port = basePort;
+    for (const Case& c : cases) {
+        UdpDoubleReceiver rx(ip, port, 2048);
+        rx.setWaitStrategy(c.receiver);
+        if (!rx.start()) return 1;
+        UdpDoubleSender tx(ip, (uint16_t)port, 0, 4);
+        ++port;
+
+        std::vector<double> latencies;
+        latencies.reserve(frames);
+        std::atomic<bool> done{false};
+
+        std::thread consumer([&] {
+            WaitStrategy wait(c.consumer);
+            UdpDoubleReceiver::Packet pkt;
+            while (!done) {
+                if (!rx.waitLatest(pkt, wait, 50'000'000)) continue;
+                const std::int64_t now = WaitStrategy::nowNanos();
+                if (!pkt.data.empty()) latencies.push_back((double)(now - (std::int64_t)pkt.data[0]) / 1000.0);
+            }
+        });
+
+        const double cpu0 = processCpuSeconds();
+        const std::int64_t t0 = WaitStrategy::nowNanos();
+        std::int64_t next = t0;
+        for (int i = 0; i < frames; ++i) {
+            next += (std::int64_t)intervalUs * 1000;
+            std::this_thread::sleep_for(std::chrono::nanoseconds(std::max<std::int64_t>(0, next - WaitStrategy::nowNanos())));
+            const double frame[2] = {(double)WaitStrategy::nowNanos(), (double)i};
+            try {
+                tx.sendAutoSeq(frame, 2);
+            } catch (const std::exception&) {
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const double wall = (double)(WaitStrategy::nowNanos() - t0) * 1e-9;
+        const double cpu = (processCpuSeconds() - cpu0) / wall;
+        done = true;
+        consumer.join();
+        const WaitStrategy::Stats ws = rx.getWaitStats();
+        rx.stop();
+
+        std::sort(latencies.begin(), latencies.end());
+        auto pct = [&](double p) {
+            return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, (std::size_t)(p * latencies.size()))];
+        };
+        std::printf("%-13s %9.1f %9.1f %9.1f %9d %7.2f %8.2f %10.1f\n",
+                    c.name, pct(0.50), pct(0.99), latencies.empty() ? 0.0 : latencies.back(),
+                    frames - (int)latencies.size(), cpu,
+                    ws.waits ? (double)ws.spinHits / (double)ws.waits : 0.0,
+                    (double)ws.spinBudgetNanos / 1000.0);
+    }
+    return 0;
+}
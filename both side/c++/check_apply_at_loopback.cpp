@@ -0,0 +1,66 @@
+// Loopback check for apply-at frames against our own receiver.
+//
+// negotiate() -> syncClock() -> sendApplyAtAutoSeq(): the handshake must
+// grant apply-at frames, the clock sync must succeed, and the frame must be
+// published by the receiver's release queue close to the requested instant.
+// Exit code 0 on success.
+
+#include "UdpDoubleReceiver.hpp"
+#include "UdpDoubleSender.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <thread>
+#include <vector>
+
+int main() {
+    // ---- CONFIG ----
+    const std::string ip = "127.0.0.1";
+    const uint16_t port = 39998;
+    const int channels = 8;
+    const int64_t leadNanos = 20'000'000;   // apply 20 ms after sending
+    // ----------------
+
+    UdpDoubleReceiver rx("0.0.0.0", port);
+    if (!rx.start()) {
+        std::fprintf(stderr, "receiver failed to start on %u\n", port);
+        return 1;
+    }
+
+    UdpDoubleSender tx(ip, port, 0, channels, true);
+    const bool negotiated = tx.negotiate();
+    const bool synced = tx.syncClock();
+    std::printf("negotiate=%s syncClock=%s offset=%lldns rtt=%lldns\n",
+                negotiated ? "ok" : "FAILED", synced ? "ok" : "FAILED",
+                (long long)tx.getClockOffsetNanos(), (long long)tx.getClockRttNanos());
+    if (!negotiated || !synced) return 1;
+
+    std::vector<double> frame((size_t)channels, 1.5);
+    const int64_t now = (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    const int64_t applyAt = now + leadNanos;   // sender's steady_clock
+    try {
+        tx.sendApplyAtAutoSeq(frame.data(), channels, applyAt);
+    } catch (const std::exception& e) {
+        std::printf("sendApplyAt FAILED: %s\n", e.what());
+        return 1;
+    }
+
+    UdpDoubleReceiver::Packet pkt;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (!rx.getLatest(pkt) && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    const UdpDoubleReceiver::ReleaseStats rs = rx.getReleaseStats();
+    rx.stop();
+    tx.close();
+
+    if (pkt.data.size() != (size_t)channels || pkt.applyAtNanos == 0) {
+        std::printf("apply-at frame NOT received\n");
+        return 1;
+    }
+    std::printf("released=%llu late=%llu error=%.0fns\n",
+                (unsigned long long)rs.released, (unsigned long long)rs.lateOnArrival, rs.meanErrorNanos);
+    return (rs.released == 1) ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+// Loopback check for authenticated traffic against our own receiver.
+//
+// With one key on both sides:
+// - negotiate() and tagged frames go through
+// - a frame tagged with another key and an untagged one are dropped
+// - a sender whose clock was an hour ahead comes back on the same local
+//   port with its real clock (a reboot): negotiate() restarts its replay
+//   window, so its new frames are accepted
+// - a bulk upload completes over the tagged ACKs
+// Exit code 0 on success.
+
+#include "BulkSender.hpp"
+#include "SteadyClock.hpp"
+#include "UdpDoubleReceiver.hpp"
+#include "UdpDoubleSender.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+static void settle() { std::this_thread::sleep_for(std::chrono::milliseconds(30)); }
+
+int main() {
+    // ---- CONFIG ----
+    const std::string ip = "127.0.0.1";
+    const uint16_t port = 39995;
+    const uint16_t rebootPort = 39994;     // local port of the "rebooted" sender
+    const int channels = 16;
+    // ----------------
+
+    std::uint8_t key[16], other[16];
+    for (int i = 0; i < 16; ++i) key[i] = other[i] = std::uint8_t(i * 7 + 1);
+    other[5] ^= 1;
+
+    UdpDoubleReceiver rx("0.0.0.0", port);
+    rx.enableAuth(key);
+    rx.enableBulk(100000);
+    if (!rx.start()) {
+        std::fprintf(stderr, "receiver failed to start on %u\n", port);
+        return 1;
+    }
+    bool ok = true;
+    std::vector<double> frame((size_t)channels, 1.0);
+    UdpDoubleReceiver::Packet pkt;
+
+    // tagged frames
+    UdpDoubleSender tx(ip, port, 0, channels, true);
+    tx.setAuthKey(key);
+    const bool negotiated = tx.negotiate();
+    for (int i = 0; i < 5; ++i) {
+        frame[0] = i;
+        tx.sendAutoSeq(frame.data(), channels);
+    }
+    settle();
+    const bool tagged = rx.getLatest(pkt) && pkt.data[0] == 4.0;
+    std::printf("negotiate=%s tagged frames=%s\n", negotiated ? "ok" : "FAILED", tagged ? "ok" : "FAILED");
+    ok = ok && negotiated && tagged;
+
+    // forged frames
+    {
+        UdpDoubleSender wrongKey(ip, port, 0, channels), noKey(ip, port, 0, channels);
+        wrongKey.setAuthKey(other);
+        frame[0] = -1;
+        wrongKey.sendWithSeq(frame.data(), channels, 1000);
+        noKey.sendWithSeq(frame.data(), channels, 1001);
+    }
+    settle();
+    const bool forgedDropped = rx.getAuthRejected() == 2 && rx.getLatest(pkt) && pkt.data[0] == 4.0;
+    std::printf("forged frames dropped=%s (authRejected=%llu)\n", forgedDropped ? "ok" : "FAILED",
+                (unsigned long long)rx.getAuthRejected());
+    ok = ok && forgedDropped;
+
+    // reboot: clock an hour ahead, then back to the real clock
+    const std::int64_t ahead = SteadyClock::nowNanos() + 3600LL * 1000000000LL;
+    {
+        UdpDoubleSender before(ip, port, rebootPort, channels, true);
+        before.setAuthKey(key);
+        for (int i = 0; i < 10; ++i) before.sendWithSeq(frame.data(), channels, 1000 + i, ahead + i);
+    }
+    settle();
+    const std::uint64_t rejectedBefore = rx.getReplayRejected();
+    bool rebootNegotiated = false;
+    {
+        UdpDoubleSender after(ip, port, rebootPort, channels, true);
+        after.setAuthKey(key);
+        rebootNegotiated = after.negotiate();
+        for (int i = 0; i < 5; ++i) {
+            frame[0] = 20 + i;
+            after.sendAutoSeq(frame.data(), channels);
+        }
+    }
+    settle();
+    const std::uint64_t rebootRejected = rx.getReplayRejected() - rejectedBefore;
+    const bool rebooted = rebootNegotiated && rebootRejected == 0 && rx.getLatest(pkt) && pkt.data[0] == 24.0;
+    std::printf("rebooted sender: negotiate=%s rejected %llu of 5 -> %s\n", rebootNegotiated ? "ok" : "FAILED",
+                (unsigned long long)rebootRejected, rebooted ? "ok" : "FAILED");
+    ok = ok && rebooted;
+
+    // bulk upload with tagged chunks and ACKs
+    std::vector<double> data(20000);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = i * 0.5;
+    BulkSender bulk(tx);
+    const BulkSender::Result r = bulk.send(data.data(), data.size());
+    settle();
+    std::vector<double> got;
+    const bool bulkOk = r.ok && rx.takeBulk(got) && got == data;
+    std::printf("bulk upload=%s (%u chunks, %.3fs)\n", bulkOk ? "ok" : "FAILED", r.chunks, r.seconds);
+    ok = ok && bulkOk;
+
+    rx.stop();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+// Simulated check: a captured bulk upload replayed under auth.
+//
+// Sender 127.0.0.1:5000 completes two tagged transfers, then the first
+// one is replayed chunk for chunk from the same port. Its chunks are
+// stamped before the sender's last completed transfer, so the receiver
+// must drop them unanswered: exactly two transfers reach takeBulk().
+// Exit code 0 on success.
+
+#include "ReceiverSimulation.hpp"
+#include "UdpAuth.hpp"
+#include "UdpBulk.hpp"
+#include "UdpDoubleReceiver.hpp"
+#include "UdpWire.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Tagged chunks of one transfer of values, sent at t0, t0 + 1 us, ...
+static void appendTransfer(std::vector<TraceDatagram>& trace, const UdpAuth& auth, std::uint32_t transferId,
+                           const std::vector<double>& values, std::uint32_t chunkDoubles, std::int64_t t0) {
+    std::vector<std::uint8_t> payload(values.size() * 8);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &values[i], 8);
+        UdpWire::put64(payload.data() + i * 8, bits);
+    }
+
+    UdpBulk::Chunk c;
+    c.transferId = transferId;
+    c.totalDoubles = (std::uint32_t)values.size();
+    c.chunkDoubles = chunkDoubles;
+    c.totalChunks = (c.totalDoubles + chunkDoubles - 1) / chunkDoubles;
+    c.crc = UdpBulk::crc32(payload.data(), payload.size());
+    for (std::uint32_t i = 0; i < c.totalChunks; ++i) {
+        const std::size_t first = std::size_t(i) * chunkDoubles;
+        c.index = i;
+        c.count = (std::uint16_t)std::min<std::size_t>(chunkDoubles, values.size() - first);
+        c.sentNanos = (std::uint64_t)(t0 + i * 1000);
+
+        TraceDatagram d;
+        d.timeNanos = t0 + i * 1000 + 50'000;
+        d.addr = 0x7F000001;
+        d.port = 5000;
+        const std::size_t n = UdpBulk::CHUNK_HEADER_BYTES + std::size_t(c.count) * 8;
+        d.bytes.resize(n + UdpAuth::TAG_BYTES);
+        UdpBulk::encodeChunkHeader(d.bytes.data(), c);
+        std::memcpy(d.bytes.data() + UdpBulk::CHUNK_HEADER_BYTES, payload.data() + first * 8, std::size_t(c.count) * 8);
+        auth.sign(d.bytes.data(), n);
+        trace.push_back(d);
+    }
+}
+
+int main() {
+    std::uint8_t key[16];
+    for (int i = 0; i < 16; ++i) key[i] = std::uint8_t(i * 17 + 3);
+    const UdpAuth auth(key);
+
+    std::vector<double> first(1000), second(1000);
+    for (std::size_t i = 0; i < first.size(); ++i) {
+        first[i] = double(i);
+        second[i] = -double(i);
+    }
+
+    std::vector<TraceDatagram> trace;
+    appendTransfer(trace, auth, 10, first, 100, 1'000'000);
+    appendTransfer(trace, auth, 11, second, 100, 2'000'000);
+    const std::size_t replayFrom = trace.size();
+    for (std::size_t i = 0; i < 10; ++i) {
+        TraceDatagram d = trace[i];
+        d.timeNanos = 3'000'000 + std::int64_t(i) * 1000;
+        trace.push_back(d);
+    }
+
+    UdpDoubleReceiver rx("0.0.0.0", 0);
+    rx.enableAuth(key);
+    rx.enableBulk(first.size());
+    SimulatedIo io(trace);
+    std::size_t acks = 0, replayAcks = 0;
+    io.setSink([&](std::int64_t t, const sockaddr_in&, const std::uint8_t*, std::size_t) {
+        ++acks;
+        if (t >= trace[replayFrom].timeNanos) ++replayAcks;
+    });
+    rx.simulate(io);
+
+    int completed = 0;
+    std::vector<double> got;
+    std::uint32_t id = 0;
+    while (rx.takeBulk(got, &id)) ++completed;
+    std::printf("completed=%d (want 2) acks=%zu replay acks=%zu replayRejected=%llu\n", completed, acks,
+                replayAcks, (unsigned long long)rx.getReplayRejected());
+    return (completed == 2 && replayAcks == 0) ? 0 : 1;
+}
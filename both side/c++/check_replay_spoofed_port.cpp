@@ -0,0 +1,63 @@
+// Simulated check: an authenticated frame replayed from a spoofed port.
+//
+// Frames seq 1..5 arrive tagged from 127.0.0.1:5000, then the captured
+// seq 1 frame is replayed from 127.0.0.1:6000. With allowSource() naming
+// port 5000 the replay is rejected as a disallowed source; without an allow
+// list it passes the (per-port) replay window but is older than the stream's
+// last frame and is dropped as a replay. Either way the latest frame must
+// stay seq 5. Exit code 0 on success.
+
+#include "ReceiverSimulation.hpp"
+#include "UdpAuth.hpp"
+#include "UdpDoubleReceiver.hpp"
+
+#include <cstdio>
+#include <vector>
+
+static TraceDatagram signedFrame(const UdpAuth& auth, std::uint32_t addr, std::uint16_t port,
+                                 std::uint32_t seq, std::int64_t timeNanos) {
+    const double values[4] = {double(seq), 1.0, 2.0, 3.0};
+    TraceDatagram d;
+    d.timeNanos = timeNanos;
+    d.addr = addr;
+    d.port = port;
+    d.bytes = SimulatedIo::encodeFrame(seq, (std::uint64_t)timeNanos, values, 4);
+    const std::size_t n = d.bytes.size();
+    d.bytes.resize(n + UdpAuth::TAG_BYTES);
+    auth.sign(d.bytes.data(), n);
+    return d;
+}
+
+static bool run(bool allowList) {
+    std::uint8_t key[16];
+    for (int i = 0; i < 16; ++i) key[i] = std::uint8_t(i * 17 + 3);
+    const UdpAuth auth(key);
+    const std::uint32_t loopback = 0x7F000001;
+
+    std::vector<TraceDatagram> trace;
+    for (std::uint32_t seq = 1; seq <= 5; ++seq)
+        trace.push_back(signedFrame(auth, loopback, 5000, seq, seq * 1'000'000));
+    TraceDatagram replay = trace.front();
+    replay.port = 6000;
+    replay.timeNanos = 10'000'000;
+    trace.push_back(replay);
+
+    UdpDoubleReceiver rx("0.0.0.0", 0);
+    rx.enableAuth(key);
+    if (allowList) rx.allowSource("127.0.0.1", 5000);
+    SimulatedIo io(trace);
+    rx.simulate(io);
+
+    UdpDoubleReceiver::Packet pkt;
+    const bool have = rx.getLatest(pkt);
+    const std::uint64_t rejected = allowList ? rx.getRejectedPackets() : rx.getReplayRejected();
+    std::printf("%s: latest seq=%u %s=%llu\n", allowList ? "allowSource(5000)" : "no allow list",
+                have ? pkt.seq : 0u, allowList ? "rejected" : "replayRejected", (unsigned long long)rejected);
+    return have && pkt.seq == 5 && rejected == 1;
+}
+
+int main() {
+    const bool a = run(true);
+    const bool b = run(false);
+    return (a && b) ? 0 : 1;
+}
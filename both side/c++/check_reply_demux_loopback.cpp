@@ -0,0 +1,66 @@
+// Loopback check for the sender's reply demultiplexing.
+//
+// A receiver sends reports every millisecond while the sender streams
+// frames; one thread drains pollReport() and the main thread runs rounds
+// of negotiate() + syncClock() on the same socket. Each caller must get
+// its own replies: every handshake and clock sync completes and reports
+// keep arriving. Exit code 0 on success.
+
+#include "UdpDoubleReceiver.hpp"
+#include "UdpDoubleSender.hpp"
+#include "UdpReport.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+int main() {
+    // ---- CONFIG ----
+    const std::string ip = "127.0.0.1";
+    const uint16_t port = 39977;
+    const int channels = 8;
+    const int rounds = 20;
+    // ----------------
+
+    UdpDoubleReceiver rx("0.0.0.0", port);
+    rx.enableReports(1);
+    if (!rx.start()) {
+        std::fprintf(stderr, "receiver failed to start on %u\n", port);
+        return 1;
+    }
+
+    UdpDoubleSender tx(ip, port, 0, channels, true);
+    std::atomic<bool> done{false};
+    std::atomic<int> reports{0};
+
+    std::thread frames([&] {
+        std::vector<double> frame((size_t)channels, 1.0);
+        while (!done) {
+            tx.sendAutoSeq(frame.data(), channels);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+    std::thread poller([&] {
+        UdpReport r;
+        while (!done) {
+            while (tx.pollReport(r)) ++reports;
+            std::this_thread::yield();
+        }
+    });
+
+    int negotiated = 0, synced = 0;
+    for (int i = 0; i < rounds; ++i) {
+        negotiated += tx.negotiate(200, 1) ? 1 : 0;
+        synced += tx.syncClock(4, 200) ? 1 : 0;
+    }
+
+    done = true;
+    frames.join();
+    poller.join();
+    rx.stop();
+
+    std::printf("negotiate %d/%d syncClock %d/%d reports %d\n", negotiated, rounds, synced, rounds, reports.load());
+    return (negotiated == rounds && synced == rounds && reports > 0) ? 0 : 1;
+}
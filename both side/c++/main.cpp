@@ -17,7 +17,7 @@ const uint16_t recvPort = 30001;   // PC receives here
 const uint16_t sendPort = 30002;   // Robot receives here
 
     const std::size_t rxBufferSize = 2048;
-    const auto endian = UdpDoubleReceiver::Endian::Big; // MUST match sender packing (BE)
+    const auto endian = UdpDoubleReceiver::Endian::Big; // nominal; frame order is auto-detected
 
     const int maxDoubles = 64; // must be >= max doubles you will send
     // ----------------
@@ -41,6 +41,10 @@ const uint16_t sendPort = 30002;   // Robot receives here
         128 * 1024                   // requested send buffer
     );
 
+    // Agree on byte order / sparse frames / limits with the robot side.
+    // Falls back to BE full frames if the peer does not answer (e.g. Java).
+    sender.negotiate();
+
     std::cout << "RX <- " << localBindIp << ":" << recvPort << "\n";
     std::cout << "TX -> " << remoteIp << ":" << sendPort << "\n";
     std::cout << "Running...\n";